@@ -0,0 +1,262 @@
+/**
+ * access_index.hpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _LZEND_ACCESS_INDEX_HPP
+#define _LZEND_ACCESS_INDEX_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "elias_fano.hpp"
+#include "lzend.hpp"
+
+namespace lzend {
+
+// random access to the text represented by an LZ-End parsing
+//
+// the phrase end positions are stored using Elias-Fano coding, and the links and extension characters in plain arrays
+// characters are extracted right to left; since every source ends at a phrase boundary, the source of a phrase suffix is again
+// a phrase suffix, so the only position that has to be located using a successor query is the rightmost one of each extracted range
+template<std::signed_integral Index = int32_t>
+class AccessIndex {
+private:
+    static constexpr size_t npos = SIZE_MAX;
+
+    size_t n_;
+    EliasFano ends_;
+    std::unique_ptr<Index[]> lnk_;
+    std::unique_ptr<char[]> ext_;
+
+    // a range of the text to extract (inclusive), the output position of l, and the phrase ending at r (or npos if unknown)
+    struct Range {
+        size_t l;
+        size_t r;
+        char* out;
+        size_t k;
+    };
+
+    size_t start(size_t const k) const {
+        return k > 0 ? ends_[k-1] + 1 : 0;
+    }
+
+    // extracts the text of the given length starting at the given position into out
+    // lookup(l, r) may return a pointer to an already extracted copy of text [l, r], whose ranges are then copied instead of being extracted again
+    template<typename Lookup>
+    void extract(size_t const pos, size_t const len, char* out, Lookup const& lookup) const {
+        assert(pos + len <= n_);
+        if(len == 0) return;
+
+        std::vector<Range> stack;
+        stack.push_back({ pos, pos + len - 1, out, npos });
+        while(!stack.empty()) {
+            auto [l, r, o, k] = stack.back();
+            stack.pop_back();
+
+            if(char const* copy = lookup(l, r)) {
+                std::copy(copy, copy + (r - l + 1), o);
+                continue;
+            }
+
+            if(k == npos) k = ends_.successor(r);
+            size_t e = ends_[k];
+            while(true) {
+                // r is contained in phrase k, which ends at e
+                if(r == e) {
+                    o[r - l] = ext_[k];
+                    if(r == l) break;
+                    --r;
+                }
+
+                size_t const s = start(k);
+                if(r >= s) {
+                    // extract the characters of [max(l, s), r] from the source of phrase k
+                    size_t const a = std::max(l, s);
+                    size_t const src_end = ends_[lnk_[k]];
+                    size_t const shift = (e - 1) - src_end;
+                    stack.push_back({ a - shift, r - shift, o + (a - l), r == e - 1 ? size_t(lnk_[k]) : npos });
+                    if(a == l) break;
+                    r = a - 1;
+                }
+
+                // continue with the previous phrase, which ends at r
+                --k;
+                e = s - 1;
+            }
+        }
+    }
+
+public:
+    AccessIndex() : n_(0) {
+    }
+
+    AccessIndex(std::span<Phrase<Index> const> const parsing) : n_(0) {
+        size_t const z = parsing.size();
+        std::vector<uint64_t> ends(z);
+        lnk_ = std::make_unique_for_overwrite<Index[]>(z);
+        ext_ = std::make_unique_for_overwrite<char[]>(z);
+        for(size_t k = 0; k < z; k++) {
+            n_ += parsing[k].len;
+            ends[k] = n_ - 1;
+            lnk_[k] = parsing[k].lnk;
+            ext_[k] = parsing[k].ext;
+        }
+        ends_ = EliasFano(ends);
+    }
+
+    AccessIndex(std::vector<Phrase<Index>> const& parsing) : AccessIndex(std::span<Phrase<Index> const>(parsing)) {
+    }
+
+    // the length of the represented text
+    size_t length() const { return n_; }
+
+    // the number of phrases
+    size_t num_phrases() const { return ends_.size(); }
+
+    // finds the phrase that contains the given text position
+    size_t phrase_of(size_t const pos) const {
+        assert(pos < n_);
+        return ends_.successor(pos);
+    }
+
+    // retrieves the character at the given text position
+    char char_at(size_t pos) const {
+        assert(pos < n_);
+        size_t k = ends_.successor(pos);
+        size_t e = ends_[k];
+        while(pos != e) {
+            // follow the link of phrase k; if pos is the second to last character of phrase k, its source is the end of the linked phrase
+            size_t const src_end = ends_[lnk_[k]];
+            pos = src_end - (e - 1 - pos);
+            k = (pos == src_end) ? size_t(lnk_[k]) : ends_.successor(pos);
+            e = ends_[k];
+        }
+        return ext_[k];
+    }
+
+    // extracts the text of the given length starting at the given position into out
+    void extract(size_t const pos, size_t const len, char* out) const {
+        extract(pos, len, out, [](size_t, size_t){ return (char const*)nullptr; });
+    }
+
+    // extracts the text of the given length starting at the given position
+    std::string extract(size_t const pos, size_t const len) const {
+        std::string s(len, 0);
+        extract(pos, len, s.data());
+        return s;
+    }
+
+    // extracts multiple ranges of the text, given as pairs of position and length, writing the i-th range to outs[i]
+    //
+    // the ranges are sorted and overlapping ranges are merged, so that every part of the text is extracted only once;
+    // the merged ranges are then extracted from left to right, and since sources always lie to the left, source ranges that have
+    // already been extracted for an earlier merged range are copied rather than extracted again
+    // if OpenMP is enabled, the merged ranges are distributed over the given number of threads, which then share only their own results
+    void extract(std::span<std::pair<size_t, size_t> const> const ranges, std::span<char* const> const outs, int const threads = 1) const {
+        assert(ranges.size() == outs.size());
+
+        // sort the ranges by position
+        std::vector<size_t> order(ranges.size());
+        for(size_t i = 0; i < order.size(); i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t const a, size_t const b){ return ranges[a].first < ranges[b].first; });
+
+        // merge overlapping and adjacent ranges, remembering the merged range for each input range
+        struct Merged { size_t beg; size_t end; size_t offs; };
+        std::vector<Merged> merged;
+        std::vector<size_t> merged_of(ranges.size());
+        size_t total = 0;
+        for(auto const i : order) {
+            auto const [pos, len] = ranges[i];
+            assert(pos + len <= n_);
+            if(merged.empty() || pos > merged.back().end) {
+                if(!merged.empty()) total += merged.back().end - merged.back().beg;
+                merged.push_back({ pos, pos + len, 0 });
+                merged.back().offs = total;
+            } else {
+                merged.back().end = std::max(merged.back().end, pos + len);
+            }
+            merged_of[i] = merged.size() - 1;
+        }
+        if(!merged.empty()) total += merged.back().end - merged.back().beg;
+
+        // extract the merged ranges
+        std::unique_ptr<char[]> buffer = std::make_unique_for_overwrite<char[]>(total);
+        size_t const num_merged = merged.size();
+        int const num_chunks = std::max(1, std::min(threads, int(num_merged)));
+
+        #pragma omp parallel for num_threads(num_chunks) if(num_chunks > 1)
+        for(int c = 0; c < num_chunks; c++) {
+            size_t const chunk_beg = num_merged * c / num_chunks;
+            size_t const chunk_end = num_merged * (c + 1) / num_chunks;
+            for(size_t m = chunk_beg; m < chunk_end; m++) {
+                // look up source ranges in the merged ranges of this chunk extracted so far
+                auto lookup = [&](size_t const l, size_t const r) -> char const* {
+                    auto const it = std::upper_bound(merged.begin() + chunk_beg, merged.begin() + m, l, [](size_t const x, Merged const& y){ return x < y.beg; });
+                    if(it == merged.begin() + chunk_beg) return nullptr;
+                    auto const& prev = *(it - 1);
+                    return r < prev.end ? buffer.get() + prev.offs + (l - prev.beg) : nullptr;
+                };
+                extract(merged[m].beg, merged[m].end - merged[m].beg, buffer.get() + merged[m].offs, lookup);
+            }
+        }
+
+        // distribute the results
+        for(size_t i = 0; i < ranges.size(); i++) {
+            auto const& m = merged[merged_of[i]];
+            auto const src = buffer.get() + m.offs + (ranges[i].first - m.beg);
+            std::copy(src, src + ranges[i].second, outs[i]);
+        }
+    }
+
+    // extracts multiple ranges of the text, given as pairs of position and length
+    std::vector<std::string> extract(std::span<std::pair<size_t, size_t> const> const ranges, int const threads = 1) const {
+        std::vector<std::string> result(ranges.size());
+        std::vector<char*> outs(ranges.size());
+        for(size_t i = 0; i < ranges.size(); i++) {
+            result[i].resize(ranges[i].second);
+            outs[i] = result[i].data();
+        }
+        extract(ranges, outs, threads);
+        return result;
+    }
+
+    // the size of this data structure in bytes
+    size_t size_in_bytes() const {
+        return ends_.size_in_bytes() + num_phrases() * (sizeof(Index) + sizeof(char));
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,130 @@
+/**
+ * bench/bench_access.cpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "access_index.hpp"
+#include "lzend.hpp"
+
+// benchmarks random access on the parsings of the given files,
+// reporting the latency percentiles of extracting substrings of a given length at uniformly random positions,
+// as well as the speedup of batch extraction over single extractions for a skewed access pattern
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        std::cerr << "usage: " << argv[0] << " [-q QUERIES] [-l LENGTH] [-b BATCH] [-t THREADS] FILE..." << std::endl;
+        return -1;
+    }
+
+    size_t num_queries = 100'000;
+    size_t len = 64;
+    size_t batch = 1000;
+    int threads = 1;
+    for(int i = 1; i < argc; i++) {
+        std::string const arg = argv[i];
+        if(arg == "-q" && i + 1 < argc) {
+            num_queries = std::stoull(argv[++i]);
+            continue;
+        } else if(arg == "-l" && i + 1 < argc) {
+            len = std::stoull(argv[++i]);
+            continue;
+        } else if(arg == "-b" && i + 1 < argc) {
+            batch = std::stoull(argv[++i]);
+            continue;
+        } else if(arg == "-t" && i + 1 < argc) {
+            threads = std::stoi(argv[++i]);
+            continue;
+        }
+
+        std::string s;
+        {
+            std::ifstream ifs(arg);
+            s = std::string(std::istreambuf_iterator<char>(ifs), {});
+        }
+        if(s.length() < len) {
+            std::cerr << arg << ": input is shorter than the extraction length" << std::endl;
+            continue;
+        }
+
+        auto const parsing = lzend::parse(s);
+        lzend::AccessIndex<int32_t> const index(parsing);
+
+        std::mt19937_64 gen(147);
+        std::uniform_int_distribution<size_t> dist(0, s.length() - len);
+        std::vector<double> latencies;
+        latencies.reserve(num_queries);
+        std::string out(len, 0);
+        for(size_t q = 0; q < num_queries; q++) {
+            auto const pos = dist(gen);
+            auto const t0 = std::chrono::steady_clock::now();
+            index.extract(pos, len, out.data());
+            latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count());
+            if(s.compare(pos, len, out) != 0) {
+                std::cerr << arg << ": extraction failed at position " << pos << std::endl;
+                return -1;
+            }
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        auto const percentile = [&](double const p){ return latencies[std::min(size_t(p * latencies.size()), latencies.size() - 1)]; };
+        std::cout << arg << "\tn=" << s.length() << "\tz=" << parsing.size() << "\tindex=" << (index.size_in_bytes() >> 10) << " KiB"
+            << "\tlen=" << len << "\tp50=" << percentile(0.5) << " us\tp99=" << percentile(0.99) << " us\tmax=" << latencies.back() << " us" << std::endl;
+
+        // skewed batch: most queries hit the neighbourhood of a few hot spots, which are chosen with geometrically decreasing probability
+        std::vector<size_t> hot(256);
+        for(auto& h : hot) h = dist(gen);
+        std::geometric_distribution<size_t> hot_dist(0.05);
+        std::uniform_int_distribution<size_t> jitter(0, 4 * len);
+        std::vector<std::pair<size_t, size_t>> ranges;
+        for(size_t q = 0; q < batch; q++) {
+            auto const pos = std::min(hot[std::min(hot_dist(gen), hot.size() - 1)] + jitter(gen), s.length() - len);
+            ranges.push_back({ pos, len });
+        }
+
+        auto const t0 = std::chrono::steady_clock::now();
+        for(auto const& [pos, len] : ranges) index.extract(pos, len, out.data());
+        auto const t1 = std::chrono::steady_clock::now();
+        auto const results = index.extract(ranges, threads);
+        auto const t2 = std::chrono::steady_clock::now();
+        for(size_t q = 0; q < batch; q++) {
+            if(s.compare(ranges[q].first, len, results[q]) != 0) {
+                std::cerr << arg << ": batch extraction failed at position " << ranges[q].first << std::endl;
+                return -1;
+            }
+        }
+
+        auto const t_single = std::chrono::duration<double, std::micro>(t1 - t0).count();
+        auto const t_batch = std::chrono::duration<double, std::micro>(t2 - t1).count();
+        std::cout << arg << "\tbatch=" << batch << "\tsingle: " << t_single << " us\tbatch: " << t_batch << " us\tspeedup: " << (t_single / t_batch) << std::endl;
+    }
+    return 0;
+}
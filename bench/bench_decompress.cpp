@@ -0,0 +1,103 @@
+/**
+ * bench/bench_decompress.cpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "decompress.hpp"
+#include "encoding.hpp"
+#include "lzend.hpp"
+
+// benchmarks the decompression throughput on the parsings of the given files,
+// both for the full parsing in memory and chunked, reading the phrases from the container format
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        std::cerr << "usage: " << argv[0] << " [-r REPETITIONS] FILE..." << std::endl;
+        return -1;
+    }
+
+    size_t reps = 3;
+    for(int i = 1; i < argc; i++) {
+        std::string const arg = argv[i];
+        if(arg == "-r" && i + 1 < argc) {
+            reps = std::stoull(argv[++i]);
+            continue;
+        }
+
+        std::string s;
+        {
+            std::ifstream ifs(arg);
+            s = std::string(std::istreambuf_iterator<char>(ifs), {});
+        }
+        auto const parsing = lzend::parse(s);
+        auto const z = parsing.size();
+
+        std::string encoded;
+        {
+            std::ostringstream oss;
+            lzend::encode(oss, parsing);
+            encoded = oss.str();
+        }
+
+        std::string out(s.length(), 0);
+        auto ends = std::make_unique<int32_t[]>(z);
+
+        // report the best of all repetitions, verifying the result
+        auto run = [&](char const* variant, auto decompress){
+            double best = std::numeric_limits<double>::max();
+            for(size_t r = 0; r < reps; r++) {
+                std::fill(out.begin(), out.end(), 0);
+                auto const t0 = std::chrono::steady_clock::now();
+                decompress();
+                best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+                if(out != s) {
+                    std::cerr << arg << ": " << variant << " decompression failed" << std::endl;
+                    std::exit(-1);
+                }
+            }
+            std::cout << arg << "\t" << variant << "\tn=" << s.length() << "\tz=" << z << "\t" << best * 1000.0 << " ms\t" << (s.length() / best) / (1 << 20) << " MiB/s" << std::endl;
+        };
+
+        run("full", [&](){
+            lzend::decompress(std::span<lzend::Phrase<int32_t> const>(parsing), out.data(), ends.get());
+        });
+        run("chunked", [&](){
+            std::istringstream iss(encoded);
+            lzend::Decoder<int32_t> dec(iss);
+            lzend::Decompressor<int32_t> decompressor(out.data(), ends.get());
+            lzend::Phrase<int32_t> f;
+            while(dec.read(f)) decompressor(f);
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * bench/bench_encode.cpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "encoding.hpp"
+#include "lzend.hpp"
+
+// benchmarks the container format on the parsings of the given files,
+// reporting the compression ratio as well as the encoding and decoding throughput
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        std::cerr << "usage: " << argv[0] << " [-r REPETITIONS] FILE..." << std::endl;
+        return -1;
+    }
+
+    size_t reps = 3;
+    for(int i = 1; i < argc; i++) {
+        std::string const arg = argv[i];
+        if(arg == "-r" && i + 1 < argc) {
+            reps = std::stoull(argv[++i]);
+            continue;
+        }
+
+        std::string s;
+        {
+            std::ifstream ifs(arg);
+            s = std::string(std::istreambuf_iterator<char>(ifs), {});
+        }
+        auto const parsing = lzend::parse(s);
+        auto const z = parsing.size();
+
+        // report the best of all repetitions
+        double best_enc = std::numeric_limits<double>::max();
+        double best_dec = std::numeric_limits<double>::max();
+        size_t bytes = 0;
+        for(size_t r = 0; r < reps; r++) {
+            std::stringstream buf;
+            auto const t0 = std::chrono::steady_clock::now();
+            bytes = lzend::encode(buf, parsing);
+            auto const t1 = std::chrono::steady_clock::now();
+            auto const decoded = lzend::decode(buf);
+            auto const t2 = std::chrono::steady_clock::now();
+            if(decoded.size() != z) {
+                std::cerr << arg << ": decoding failed" << std::endl;
+                return -1;
+            }
+            best_enc = std::min(best_enc, std::chrono::duration<double>(t1 - t0).count());
+            best_dec = std::min(best_dec, std::chrono::duration<double>(t2 - t1).count());
+        }
+
+        auto const mphrases = [&](double const t){ return (z / t) / 1e6; };
+        std::cout << arg << "\tn=" << s.length() << "\tz=" << z
+            << "\tbytes=" << bytes << " (" << 100.0 * bytes / std::max(s.length(), size_t(1)) << "% of input, "
+            << 8.0 * bytes / std::max(z, size_t(1)) << " bits/phrase)"
+            << "\tencode: " << mphrases(best_enc) << " M phrases/s"
+            << "\tdecode: " << mphrases(best_dec) << " M phrases/s" << std::endl;
+    }
+    return 0;
+}
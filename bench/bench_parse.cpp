@@ -0,0 +1,156 @@
+/**
+ * bench/bench_parse.cpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+
+#include "lzend.hpp"
+#include "reference.hpp"
+
+// benchmarks the throughput of lzend::parse on the given files, e.g., the Pizza&Chili corpus,
+// using different predecessor data structures for the marked phrases,
+// as well as the parallel chunked parsing and the bounded-latency limits and the resulting increase of the number of phrases
+// if a document size is given, the files are also split into documents of that size, which are parsed one by one
+// using lzend::parse and a reused lzend::Parser, as well as concurrently using lzend::parse_batch
+// if a reference dictionary is given (see lzend -R), the files are also parsed against it
+int main(int argc, char** argv) {
+    if(argc < 2) {
+        std::cerr << "usage: " << argv[0] << " [-r REPETITIONS] [-c CHUNKS] [-t THREADS] [-d DOCUMENT_SIZE] [-R REFERENCE] FILE..." << std::endl;
+        return -1;
+    }
+
+    size_t reps = 3;
+    size_t chunks = 8;
+    int threads = 0;
+    size_t doc_size = 0;
+    lzend::Reference ref;
+    for(int i = 1; i < argc; i++) {
+        std::string const arg = argv[i];
+        if(arg == "-r" && i + 1 < argc) {
+            reps = std::stoull(argv[++i]);
+            continue;
+        } else if(arg == "-c" && i + 1 < argc) {
+            chunks = std::stoull(argv[++i]);
+            continue;
+        } else if(arg == "-t" && i + 1 < argc) {
+            threads = std::stoi(argv[++i]);
+            continue;
+        } else if(arg == "-d" && i + 1 < argc) {
+            doc_size = std::stoull(argv[++i]);
+            continue;
+        } else if(arg == "-R" && i + 1 < argc) {
+            ref = lzend::Reference(std::string(argv[++i]));
+            if(!ref.good()) {
+                std::cerr << "failed to load reference dictionary: " << argv[i] << std::endl;
+                return -1;
+            }
+            continue;
+        }
+
+        std::string s;
+        {
+            std::ifstream ifs(arg);
+            s = std::string(std::istreambuf_iterator<char>(ifs), {});
+        }
+
+        // report the best of all repetitions for each predecessor data structure
+        size_t z_seq = 0;
+        auto run = [&](std::string const& variant, auto parse){
+            double best = std::numeric_limits<double>::max();
+            size_t z = 0;
+            for(size_t r = 0; r < reps; r++) {
+                auto const t0 = std::chrono::steady_clock::now();
+                z = parse(s).size();
+                best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+            }
+            if(z_seq == 0) z_seq = z;
+            std::cout << arg << "\t" << variant << "\tn=" << s.length() << "\tz=" << z << " (+" << 100.0 * (double(z) / z_seq - 1.0) << "%)\t"
+                << best * 1000.0 << " ms\t" << (s.length() / best) / (1 << 20) << " MiB/s" << std::endl;
+        };
+
+        using RMQ = rmq::RMQ<int32_t, 64, uint32_t>;
+        run("btree", [](std::string const& s){ return lzend::parse<int32_t, RMQ, ordered::btree::Map<int32_t, int32_t>>(s); });
+        run("range_marking", [](std::string const& s){ return lzend::parse<int32_t, RMQ, ordered::range_marking::Map<uint32_t, int32_t>>(s); });
+        run("bit_trie", [](std::string const& s){ return lzend::parse<int32_t, RMQ, ordered::bit_trie::Map<uint32_t, int32_t>>(s); });
+
+        lzend::Options options;
+        options.threads = threads;
+        options.num_chunks = chunks;
+        options.repair_boundaries = false;
+        run("btree, " + std::to_string(chunks) + " chunks", [&](std::string const& s){ return lzend::parse(s, options); });
+        options.repair_boundaries = true;
+        run("btree, " + std::to_string(chunks) + " chunks, repaired", [&](std::string const& s){ return lzend::parse(s, options); });
+        run("range_marking, " + std::to_string(chunks) + " chunks, repaired", [&](std::string const& s){ return lzend::parse<int32_t, RMQ, ordered::range_marking::Map<uint32_t, int32_t>>(s, options); });
+
+        // bounded latency
+        lzend::Options bounded;
+        bounded.max_rmq_interval = 1024;
+        run("btree, RMQ intervals <= 1024", [&](std::string const& s){ return lzend::parse(s, bounded); });
+        bounded = lzend::Options();
+        bounded.requery = false;
+        run("btree, no requeries", [&](std::string const& s){ return lzend::parse(s, bounded); });
+        bounded = lzend::Options();
+        bounded.max_phrase_len = 256;
+        run("btree, phrases <= 256", [&](std::string const& s){ return lzend::parse(s, bounded); });
+
+        if(ref.size() > 0) {
+            run("btree, against reference", [&](std::string const& s){ return lzend::parse(s, ref); });
+        }
+
+        if(doc_size > 0) {
+            std::vector<std::string_view> docs;
+            for(size_t j = 0; j < s.length(); j += doc_size) docs.push_back(std::string_view(s).substr(j, doc_size));
+
+            // the parsings of the documents are concatenated, so the number of phrases can be reported as for the whole input
+            std::string const suffix = ", " + std::to_string(docs.size()) + " documents";
+            run("btree" + suffix, [&](std::string const&){
+                std::vector<lzend::Phrase<int32_t>> parsing;
+                for(auto const doc : docs) lzend::parse(doc, [&](lzend::Phrase<int32_t> const& f){ parsing.push_back(f); });
+                return parsing;
+            });
+            run("btree" + suffix + ", reused parser", [&](std::string const&){
+                std::vector<lzend::Phrase<int32_t>> parsing;
+                lzend::Parser parser;
+                for(auto const doc : docs) parser.parse(doc, [&](lzend::Phrase<int32_t> const& f){ parsing.push_back(f); });
+                return parsing;
+            });
+            lzend::Options batch_options;
+            batch_options.threads = threads;
+            run("btree" + suffix + ", batch", [&](std::string const&){
+                std::vector<lzend::Phrase<int32_t>> parsing;
+                for(auto const& doc_parsing : lzend::parse_batch(docs, batch_options)) parsing.insert(parsing.end(), doc_parsing.begin(), doc_parsing.end());
+                return parsing;
+            });
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+/**
+ * bench/bench_rmq.cpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <rmq/rmq.hpp>
+
+// benchmarks the in-block minimum scan used by rmq::RMQ for short intervals, scalar vs. vectorized,
+// as well as the block RMQ engines
+int main() {
+    size_t const n = 1ULL << 24;
+    size_t const num_queries = 10'000'000;
+    size_t const max_len = 3 * 64; // nb: the longest interval rmq::RMQ scans naively
+
+    // generate LCP-like data and queries
+    std::mt19937_64 gen(147);
+    std::vector<int32_t> data(n);
+    for(auto& x : data) x = gen() % 64;
+
+    std::vector<std::pair<uint32_t, uint32_t>> queries(num_queries);
+    for(auto& q : queries) {
+        auto const len = 1 + gen() % max_len;
+        auto const beg = gen() % (n - len);
+        q = { uint32_t(beg), uint32_t(beg + len) };
+    }
+
+    auto run = [&](char const* name, auto scan){
+        auto const t0 = std::chrono::steady_clock::now();
+        uint64_t chk = 0;
+        for(auto const& q : queries) {
+            int32_t min;
+            chk += scan(q.first, q.second, min) + min;
+        }
+        auto const t = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << name << "\t" << t / num_queries << " ns/query\t(checksum: " << chk << ")" << std::endl;
+        return chk;
+    };
+
+    std::cout << "SIMD lanes: " << rmq::internal::simd_lanes << std::endl;
+    auto const chk_scalar = run("scalar", [&](uint32_t beg, uint32_t end, int32_t& min){ return rmq::min_scan_scalar<true>(data.data(), beg, end, min); });
+    auto const chk_simd = run("simd", [&](uint32_t beg, uint32_t end, int32_t& min){ return rmq::min_scan<true>(data.data(), beg, end, min); });
+    if(chk_scalar != chk_simd) {
+        std::cerr << "results differ!" << std::endl;
+        return -1;
+    }
+
+    // the same for bytes, as used by lzend::CompactLCP
+    std::vector<uint8_t> bytes(data.begin(), data.end());
+    auto byte_scan = [&](auto scan){
+        return [&, scan](uint32_t beg, uint32_t end, int32_t& min){ uint8_t m; auto const p = scan(bytes.data(), beg, end, m); min = m; return p; };
+    };
+    std::cout << "SIMD lanes for bytes: " << rmq::internal::simd_lanes_u8 << std::endl;
+    auto const chk_scalar_u8 = run("scalar (bytes)", byte_scan([](uint8_t const* d, uint32_t beg, uint32_t end, uint8_t& min){ return rmq::min_scan_scalar<true>(d, beg, end, min); }));
+    auto const chk_simd_u8 = run("simd (bytes)", byte_scan([](uint8_t const* d, uint32_t beg, uint32_t end, uint8_t& min){ return rmq::min_scan<true>(d, beg, end, min); }));
+    if(chk_scalar_u8 != chk_simd_u8 || chk_scalar_u8 != chk_scalar) {
+        std::cerr << "results differ!" << std::endl;
+        return -1;
+    }
+
+    // compare the block RMQ engines on arbitrary intervals
+    for(auto& q : queries) {
+        auto const a = gen() % n, b = gen() % n;
+        q = { uint32_t(std::min(a, b)), uint32_t(std::max(a, b)) };
+    }
+
+    auto run_engine = [&](char const* name, auto const& rmq){
+        auto const t0 = std::chrono::steady_clock::now();
+        uint64_t chk = 0;
+        for(auto const& q : queries) chk += rmq(q.first, q.second);
+        auto const t = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << name << "\t" << t / num_queries << " ns/query\t(checksum: " << chk << ")" << std::endl;
+        return chk;
+    };
+
+    auto const chk_bfc = run_engine("bender-farach-colton", rmq::RMQ<int32_t, 64, uint32_t, true, rmq::RMQBenderFarachColton>(data.data(), n));
+    auto const chk_bitmask = run_engine("stack-bitmask", rmq::RMQ<int32_t, 64, uint32_t, true, rmq::RMQStackBitmask>(data.data(), n));
+    if(chk_bfc != chk_bitmask) {
+        std::cerr << "results differ!" << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,253 @@
+/**
+ * bench/bench_suite.cpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "lzend.hpp"
+
+// synthetic inputs, generated deterministically
+std::string random_text(size_t const n, size_t const sigma) {
+    std::mt19937_64 gen(147);
+    std::uniform_int_distribution<int> dist(0, sigma - 1);
+    std::string s(n, 0);
+    for(auto& c : s) c = sigma <= 4 ? "ACGT"[dist(gen)] : char(dist(gen));
+    return s;
+}
+
+std::string repetitive_text(size_t const n, size_t const period, double const mutation_rate) {
+    std::mt19937_64 gen(147);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    std::uniform_int_distribution<int> letter('a', 'z');
+    auto const base = random_text(period, 26);
+    std::string s(n, 0);
+    for(size_t i = 0; i < n; i++) s[i] = coin(gen) < mutation_rate ? char(letter(gen)) : base[i % period];
+    return s;
+}
+
+std::string fibonacci_text(size_t const n) {
+    std::string a = "b", b = "a";
+    while(b.length() < n) {
+        auto c = b + a;
+        a = std::move(b);
+        b = std::move(c);
+    }
+    b.resize(n);
+    return b;
+}
+
+// writes a string as a JSON string literal
+std::string json_string(std::string const& s) {
+    std::string r = "\"";
+    for(char const c : s) {
+        if(c == '"' || c == '\\') r.push_back('\\');
+        r.push_back(c);
+    }
+    return r + "\"";
+}
+
+// extracts the raw value of a top-level field from a JSON object written by this benchmark
+std::string json_field(std::string const& json, std::string const& key) {
+    auto const needle = "\"" + key + "\":";
+    auto pos = json.find(needle);
+    if(pos == std::string::npos) return {};
+    pos += needle.length();
+    return json.substr(pos, json.find_first_of(",}", pos) - pos);
+}
+
+// runs the benchmark for all component variants of lzend::parse on a corpus of real and synthetic inputs
+// and writes one JSON object per run and line to stdout, e.g., for tracking performance across commits
+//
+// each run is executed in a child process, so that the reported peak resident set size belongs to that run alone
+// if a baseline (the output of a previous run) is given, each throughput is compared against it,
+// and the exit code is nonzero if any run is slower than the baseline by more than the tolerance
+int main(int argc, char** argv) {
+    size_t reps = 1;
+    size_t synthetic_n = 4ULL << 20;
+    std::string label;
+    std::string baseline_file;
+    double tolerance = 0.1;
+    std::vector<std::string> files;
+    for(int i = 1; i < argc; i++) {
+        std::string const arg = argv[i];
+        if(arg == "-r" && i + 1 < argc) {
+            reps = std::stoull(argv[++i]);
+        } else if(arg == "-n" && i + 1 < argc) {
+            synthetic_n = std::stoull(argv[++i]);
+        } else if(arg == "-l" && i + 1 < argc) {
+            label = argv[++i];
+        } else if(arg == "-b" && i + 1 < argc) {
+            baseline_file = argv[++i];
+        } else if(arg == "-x" && i + 1 < argc) {
+            tolerance = std::stod(argv[++i]);
+        } else if(arg == "-h") {
+            std::cerr << "usage: " << argv[0] << " [-r REPETITIONS] [-n SYNTHETIC_LENGTH] [-l LABEL] [-b BASELINE [-x TOLERANCE]] [FILE...]" << std::endl;
+            return 0;
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    // load the baseline
+    std::vector<std::string> baseline;
+    if(!baseline_file.empty()) {
+        std::ifstream ifs(baseline_file);
+        for(std::string line; std::getline(ifs, line);) baseline.push_back(line);
+    }
+    auto const run_key = [](std::string const& json){
+        return json_field(json, "input") + json_field(json, "n") + json_field(json, "rmq") + json_field(json, "marked");
+    };
+    size_t num_regressions = 0;
+
+    // the corpus, given as input names and generators, so that only the child processes hold the input
+    struct Input {
+        std::string name;
+        std::string (*generate)(std::string const& file, size_t n);
+        std::string file;
+    };
+    std::vector<Input> corpus;
+    for(auto const& file : files) {
+        corpus.push_back({ file, [](std::string const& file, size_t){
+            std::ifstream ifs(file);
+            return std::string(std::istreambuf_iterator<char>(ifs), {});
+        }, file });
+    }
+    if(synthetic_n > 0) {
+        corpus.push_back({ "synthetic:random-dna", [](std::string const&, size_t n){ return random_text(n, 4); }, {} });
+        corpus.push_back({ "synthetic:random-bytes", [](std::string const&, size_t n){ return random_text(n, 256); }, {} });
+        corpus.push_back({ "synthetic:repetitive", [](std::string const&, size_t n){ return repetitive_text(n, 1 << 16, 0.001); }, {} });
+        corpus.push_back({ "synthetic:fibonacci", [](std::string const&, size_t n){ return fibonacci_text(n); }, {} });
+    }
+
+    // the component variants
+    using BFC = rmq::RMQ<int32_t, 64, uint32_t>;
+    using StackBitmask = rmq::RMQ<int32_t, 64, uint32_t, true, rmq::RMQStackBitmask>;
+    using BTree = ordered::btree::Map<int32_t, int32_t>;
+
+    struct Variant {
+        char const* rmq;
+        char const* marked;
+        std::vector<lzend::Phrase<int32_t>> (*parse)(std::string const& s, lzend::Stats& stats);
+    };
+    std::vector<Variant> const variants = {
+        { "bender_farach_colton", "btree65", [](std::string const& s, lzend::Stats& stats){ return lzend::parse<int32_t, BFC, BTree>(s, {}, stats); } },
+        { "bender_farach_colton", "btree17", [](std::string const& s, lzend::Stats& stats){ return lzend::parse<int32_t, BFC, ordered::btree::Map<int32_t, int32_t, 17>>(s, {}, stats); } },
+        { "bender_farach_colton", "btree33", [](std::string const& s, lzend::Stats& stats){ return lzend::parse<int32_t, BFC, ordered::btree::Map<int32_t, int32_t, 33>>(s, {}, stats); } },
+        { "bender_farach_colton", "btree129", [](std::string const& s, lzend::Stats& stats){ return lzend::parse<int32_t, BFC, ordered::btree::Map<int32_t, int32_t, 129>>(s, {}, stats); } },
+        { "bender_farach_colton", "range_marking", [](std::string const& s, lzend::Stats& stats){ return lzend::parse<int32_t, BFC, ordered::range_marking::Map<uint32_t, int32_t>>(s, {}, stats); } },
+        { "bender_farach_colton", "bit_trie", [](std::string const& s, lzend::Stats& stats){ return lzend::parse<int32_t, BFC, ordered::bit_trie::Map<uint32_t, int32_t>>(s, {}, stats); } },
+        { "stack_bitmask", "btree65", [](std::string const& s, lzend::Stats& stats){ return lzend::parse<int32_t, StackBitmask, BTree>(s, {}, stats); } },
+        { "stack_bitmask", "range_marking", [](std::string const& s, lzend::Stats& stats){ return lzend::parse<int32_t, StackBitmask, ordered::range_marking::Map<uint32_t, int32_t>>(s, {}, stats); } },
+    };
+
+    for(auto const& input : corpus) {
+        for(auto const& variant : variants) {
+            std::cout.flush();
+            int fds[2];
+            if(pipe(fds) != 0) { std::perror("pipe"); return -1; }
+
+            pid_t const pid = fork();
+            if(pid < 0) { std::perror("fork"); return -1; }
+            if(pid == 0) {
+                // child: run the benchmark, keeping the statistics of the best repetition
+                close(fds[0]);
+                auto const s = input.generate(input.file, synthetic_n);
+                lzend::Stats best;
+                size_t z = 0;
+                double best_time = std::numeric_limits<double>::max();
+                for(size_t r = 0; r < std::max(reps, size_t(1)); r++) {
+                    lzend::Stats stats;
+                    auto const t0 = std::chrono::steady_clock::now();
+                    z = variant.parse(s, stats).size();
+                    auto const t = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+                    if(t < best_time) { best_time = t; best = stats; }
+                }
+
+                std::ostringstream json;
+                json << "{\"label\":" << json_string(label)
+                    << ",\"input\":" << json_string(input.name)
+                    << ",\"n\":" << s.length()
+                    << ",\"rmq\":" << json_string(variant.rmq)
+                    << ",\"marked\":" << json_string(variant.marked)
+                    << ",\"z\":" << z
+                    << ",\"time_ms\":" << best_time * 1000.0
+                    << ",\"throughput_mib_s\":" << (s.length() / best_time) / (1 << 20)
+                    << ",\"peak_rss\":" << lzend::peak_memory()
+                    << ",\"stats\":";
+                best.print_json(json);
+                json << "}\n";
+
+                auto const out = json.str();
+                [[maybe_unused]] auto const written = write(fds[1], out.data(), out.size());
+                close(fds[1]);
+                _exit(0);
+            }
+
+            // parent: forward the child's result
+            close(fds[1]);
+            std::string result;
+            char buf[4096];
+            ssize_t k;
+            while((k = read(fds[0], buf, sizeof(buf))) > 0) result.append(buf, k);
+            close(fds[0]);
+
+            int status;
+            waitpid(pid, &status, 0);
+            if(!WIFEXITED(status) || WEXITSTATUS(status) != 0 || result.empty()) {
+                std::cerr << input.name << ": " << variant.rmq << "/" << variant.marked << " failed" << std::endl;
+                continue;
+            }
+            std::cout << result;
+
+            // compare against the baseline
+            for(auto const& line : baseline) {
+                if(run_key(line) != run_key(result)) continue;
+                auto const before = std::stod(json_field(line, "throughput_mib_s"));
+                auto const after = std::stod(json_field(result, "throughput_mib_s"));
+                if(after < before * (1.0 - tolerance)) {
+                    std::cerr << "regression: " << input.name << " " << variant.rmq << "/" << variant.marked << ": "
+                        << before << " -> " << after << " MiB/s" << std::endl;
+                    ++num_regressions;
+                }
+                break;
+            }
+        }
+    }
+    return num_regressions > 0 ? 1 : 0;
+}
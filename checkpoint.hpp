@@ -0,0 +1,264 @@
+/**
+ * checkpoint.hpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _LZEND_CHECKPOINT_HPP
+#define _LZEND_CHECKPOINT_HPP
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "mapped_file.hpp"
+
+namespace lzend {
+
+template<std::signed_integral Index, typename Symbol> struct Phrase;
+
+namespace internal {
+
+// computes a 64-bit fingerprint of the input to recognize it when resuming
+inline uint64_t fingerprint(std::string_view const s) {
+    constexpr uint64_t m = 0x9E3779B97F4A7C15ULL;
+    uint64_t h = s.length() * m;
+    size_t i = 0;
+    for(; i + 8 <= s.length(); i += 8) {
+        uint64_t w;
+        std::memcpy(&w, s.data() + i, 8);
+        h = (h ^ w) * m;
+        h ^= h >> 29;
+    }
+    for(; i < s.length(); i++) {
+        h = (h ^ uint8_t(s[i])) * m;
+    }
+    return h ^ (h >> 32);
+}
+
+// writes the given bytes to the file descriptor, returning false on failure
+inline bool write_fully(int const fd, void const* data, size_t size, off_t offset) {
+    auto p = (char const*)data;
+    while(size > 0) {
+        auto const w = pwrite(fd, p, std::min(size, size_t(1) << 30), offset);
+        if(w <= 0) return false;
+        p += w;
+        size -= w;
+        offset += w;
+    }
+    return true;
+}
+
+// the header of each checkpoint file, which makes sure its contents belong to the input at hand
+// the size of 64 bytes keeps the following data aligned when the file is memory-mapped
+struct CheckpointHeader {
+    char magic[4];
+    uint32_t index_size;
+    uint64_t n;
+    uint64_t fingerprint;
+    uint64_t pos;    // for snapshots: the position in the input to resume parsing from
+    uint64_t prefix; // for snapshots: the number of phrases to read from the parsing file
+    uint64_t tail;   // for snapshots: the number of phrases following the header
+    uint32_t symbol_size;
+    char reserved[12];
+};
+
+static_assert(sizeof(CheckpointHeader) == 64);
+
+// persists the LCP array and the permuted ISA of a parse, as well as periodic snapshots of the parsing loop, in a directory,
+// so that a parse of the same input that has been interrupted can be resumed from the last snapshot
+//
+// the arrays are stored as raw index arrays following a header, and memory-mapped when resuming
+// the marked phrases are not stored, because they are determined by the parsing and the permuted ISA
+//
+// a snapshot consists of the phrases up to the current one; since merges can change phrases arbitrarily far back,
+// the phrases are kept in a parsing file that only ever holds a valid prefix of the parsing, and a state file that is replaced atomically
+// and lists the length of that prefix followed by the phrases since then; the parsing file is only updated after the state file has been replaced,
+// so the latest state file can always be completed to a consistent snapshot
+template<std::signed_integral Index, typename Symbol = char>
+class Checkpoint {
+private:
+    std::filesystem::path dir_;
+    Index n_;
+    uint64_t fingerprint_;
+
+    MappedFile lcp_file_;
+    MappedFile isa_file_;
+
+    int parsing_fd_;     // the parsing file
+    size_t num_written_; // the number of valid phrases in the parsing file
+
+    std::filesystem::path path(char const* name) const { return dir_ / name; }
+
+    CheckpointHeader header(char const* magic) const {
+        CheckpointHeader h = {};
+        std::memcpy(h.magic, magic, 4);
+        h.index_size = sizeof(Index);
+        h.symbol_size = sizeof(Symbol);
+        h.n = n_;
+        h.fingerprint = fingerprint_;
+        return h;
+    }
+
+    // nb: the file names serve as magic numbers
+    bool matches(CheckpointHeader const& h, char const* magic) const {
+        return std::memcmp(h.magic, magic, 4) == 0 && h.index_size == sizeof(Index) && h.symbol_size == sizeof(Symbol) && h.n == uint64_t(n_) && h.fingerprint == fingerprint_;
+    }
+
+    // writes a file consisting of the header followed by the given data, replacing any previous version atomically
+    bool write_file(char const* name, CheckpointHeader const& h, void const* data, size_t const size) const {
+        auto const tmp = path(name).string() + ".tmp";
+        int const fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) return false;
+        bool const ok = write_fully(fd, &h, sizeof(h), 0) && write_fully(fd, data, size, sizeof(h)) && fsync(fd) == 0;
+        ::close(fd);
+        return ok && std::rename(tmp.c_str(), path(name).c_str()) == 0;
+    }
+
+    // maps the array stored in the given file, or returns nullptr if it does not belong to the input
+    Index const* map_array(char const* name, MappedFile& file) const {
+        file = MappedFile(path(name).string(), false);
+        if(!file.good() || file.size() != sizeof(CheckpointHeader) + size_t(n_) * sizeof(Index)) return nullptr;
+        if(!matches(*(CheckpointHeader const*)file.data(), name)) return nullptr;
+        return (Index const*)(file.data() + sizeof(CheckpointHeader));
+    }
+
+public:
+    // prepares checkpointing the parse of the given input in the given directory, which is created if necessary
+    Checkpoint(std::string const& dir, std::span<Symbol const> const s)
+        : dir_(dir), n_(s.size()), fingerprint_(fingerprint(std::string_view((char const*)s.data(), s.size_bytes()))), parsing_fd_(-1), num_written_(0) {
+        std::error_code ec;
+        std::filesystem::create_directories(dir_, ec);
+    }
+
+    ~Checkpoint() {
+        if(parsing_fd_ >= 0) ::close(parsing_fd_);
+    }
+
+    Checkpoint(Checkpoint const&) = delete;
+    Checkpoint& operator=(Checkpoint const&) = delete;
+
+    // maps the LCP array and the permuted ISA of a previous run on the same input, returning false if there are none
+    bool load_arrays(Index const*& lcp, Index const*& isa) {
+        lcp = map_array("lcp", lcp_file_);
+        isa = map_array("isa", isa_file_);
+        if(lcp && isa) return true;
+
+        lcp_file_.close();
+        isa_file_.close();
+        return false;
+    }
+
+    // stores the LCP array and the permuted ISA, returning false on failure
+    bool save_arrays(Index const* lcp, Index const* isa) const {
+        return write_file("lcp", header("lcp"), lcp, size_t(n_) * sizeof(Index))
+            && write_file("isa", header("isa"), isa, size_t(n_) * sizeof(Index));
+    }
+
+    // loads the latest snapshot into the given parsing and returns the position to resume parsing from,
+    // or zero if there is no valid snapshot for the input or the parsing file cannot be opened
+    Index load_snapshot(std::vector<Phrase<Index, Symbol>>& parsing) {
+        parsing.clear();
+        num_written_ = 0;
+        parsing_fd_ = open(path("parsing").c_str(), O_RDWR | O_CREAT, 0644);
+        if(parsing_fd_ < 0) return 0;
+
+        MappedFile state(path("state").string(), false);
+        if(!state.good() || state.size() < sizeof(CheckpointHeader)) return 0;
+        auto const& h = *(CheckpointHeader const*)state.data();
+        if(!matches(h, "sta") || state.size() != sizeof(CheckpointHeader) + h.tail * sizeof(Phrase<Index, Symbol>)) return 0;
+
+        MappedFile prefix(path("parsing").string());
+        if(prefix.size() < h.prefix * sizeof(Phrase<Index, Symbol>) || h.pos > uint64_t(n_)) return 0;
+
+        auto const* prefix_phrases = (Phrase<Index, Symbol> const*)prefix.data();
+        auto const* tail_phrases = (Phrase<Index, Symbol> const*)(state.data() + sizeof(CheckpointHeader));
+        parsing.reserve(h.prefix + h.tail);
+        parsing.insert(parsing.end(), prefix_phrases, prefix_phrases + h.prefix);
+        parsing.insert(parsing.end(), tail_phrases, tail_phrases + h.tail);
+
+        // the phrases must cover exactly the parsed prefix, otherwise the state is stale or damaged
+        bool valid = true;
+        uint64_t len = 0;
+        for(auto const& f : parsing) {
+            valid = valid && f.len > 0;
+            len += uint64_t(f.len);
+        }
+        if(!valid || len != h.pos) {
+            parsing.clear();
+            return 0;
+        }
+
+        num_written_ = h.prefix;
+        return Index(h.pos);
+    }
+
+    // takes a snapshot of the given parsing, from which parsing will be resumed at the given position,
+    // where the phrases from the given one onwards may have changed since the previous snapshot; returns false on failure
+    bool save_snapshot(std::vector<Phrase<Index, Symbol>> const& parsing, Index const pos, size_t const first_changed) {
+        if(parsing_fd_ < 0) return false;
+
+        // commit the state, consisting of the valid prefix of the parsing file and the phrases after it
+        size_t const prefix = std::min(num_written_, first_changed);
+        auto h = header("sta");
+        h.pos = pos;
+        h.prefix = prefix;
+        h.tail = parsing.size() - prefix;
+        if(!write_file("state", h, parsing.data() + prefix, h.tail * sizeof(Phrase<Index, Symbol>))) return false;
+
+        // extend the parsing file by the tail for the next snapshot
+        num_written_ = prefix;
+        if(!write_fully(parsing_fd_, parsing.data() + prefix, h.tail * sizeof(Phrase<Index, Symbol>), prefix * sizeof(Phrase<Index, Symbol>))) return false;
+        if(ftruncate(parsing_fd_, parsing.size() * sizeof(Phrase<Index, Symbol>)) != 0) return false;
+        num_written_ = parsing.size();
+        return true;
+    }
+
+    // removes the checkpoint files after the parse has been completed
+    void remove() {
+        lcp_file_.close();
+        isa_file_.close();
+        if(parsing_fd_ >= 0) ::close(parsing_fd_);
+        parsing_fd_ = -1;
+
+        std::error_code ec;
+        for(auto const name : { "lcp", "isa", "state", "parsing" }) std::filesystem::remove(path(name), ec);
+    }
+};
+
+}
+
+}
+
+#endif
@@ -0,0 +1,170 @@
+/**
+ * compact_lcp.hpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _LZEND_COMPACT_LCP_HPP
+#define _LZEND_COMPACT_LCP_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <rmq/rmq.hpp>
+
+namespace lzend {
+
+// an LCP array with range minimum queries that stores values below 255 in a single byte each and larger values in a table of exceptions,
+// which needs about 1.2 bytes per entry plus sizeof(Index) bytes per exception and the RMQs, so it pays off if most LCP values are small
+//
+// the exceptions are stored in text order and located using a bit vector that marks them, sampled for rank queries;
+// range minima are found using an RMQ over the bytes, and if the minimum byte marks an exception, all values in the range are exceptions,
+// which are then consecutive in the table, so the minimum is found using an RMQ over the exception values instead
+template<std::signed_integral Index>
+class CompactLCP {
+private:
+    using Unsigned = std::make_unsigned_t<Index>;
+    static constexpr uint8_t large_ = UINT8_MAX;
+
+    Index n_;
+    Index max_;
+    std::unique_ptr<uint8_t[]> bytes_;
+    std::unique_ptr<uint64_t[]> is_exception_;
+    std::unique_ptr<Index[]> exception_rank_; // the number of exceptions before each 64 entries
+    std::vector<Index> exceptions_;
+    rmq::RMQ<uint8_t, 64, Unsigned> rmq_;
+    rmq::RMQ<Index, 64, Unsigned> exception_rmq_;
+
+    // the number of exceptions before entry i
+    size_t rank(Index const i) const {
+        return exception_rank_[i / 64] + std::popcount(is_exception_[i / 64] & ((uint64_t(1) << (i % 64)) - 1));
+    }
+
+public:
+    // counts the values of the given LCP array that would be exceptions
+    static size_t count_exceptions(Index const* lcp, Index const n, int const threads = 1) {
+        size_t num = 0;
+        #pragma omp parallel for num_threads(threads) if(threads > 1) reduction(+:num)
+        for(Index i = 0; i < n; i++) num += (lcp[i] >= large_);
+        return num;
+    }
+
+    // reports the space needed for an LCP array of the given length with the given number of exceptions, including the RMQs
+    static size_t size_in_bytes(size_t const n, size_t const num_exceptions) {
+        size_t const num_words = (n + 63) / 64;
+        return n + num_words * (sizeof(uint64_t) + sizeof(Index)) + num_exceptions * sizeof(Index)
+            + decltype(rmq_)::size_in_bytes(n) + decltype(exception_rmq_)::size_in_bytes(num_exceptions);
+    }
+
+    CompactLCP() : n_(0), max_(0) {
+    }
+
+    // encodes the given LCP array, which is no longer needed afterwards, using the given number of threads if OpenMP is enabled
+    CompactLCP(Index const* lcp, Index const n, int const threads = 1) : n_(n), max_(0) {
+        size_t const num_words = (size_t(n) + 63) / 64;
+        bytes_ = std::make_unique_for_overwrite<uint8_t[]>(n);
+        is_exception_ = std::make_unique<uint64_t[]>(num_words);
+        exception_rank_ = std::make_unique<Index[]>(num_words);
+
+        Index max = 0;
+        #pragma omp parallel for num_threads(threads) if(threads > 1) reduction(max:max)
+        for(size_t w = 0; w < num_words; w++) {
+            Index const beg = w * 64;
+            Index const end = std::min(beg + 64, n);
+            uint64_t mask = 0;
+            for(Index i = beg; i < end; i++) {
+                bytes_[i] = lcp[i] < large_ ? uint8_t(lcp[i]) : large_;
+                mask |= uint64_t(lcp[i] >= large_) << (i - beg);
+                max = std::max(max, lcp[i]);
+            }
+            is_exception_[w] = mask;
+        }
+        max_ = max;
+
+        size_t num_exceptions = 0;
+        for(size_t w = 0; w < num_words; w++) {
+            exception_rank_[w] = num_exceptions;
+            num_exceptions += std::popcount(is_exception_[w]);
+        }
+
+        exceptions_.resize(num_exceptions);
+        #pragma omp parallel for num_threads(threads) if(threads > 1)
+        for(size_t w = 0; w < num_words; w++) {
+            size_t k = exception_rank_[w];
+            for(uint64_t mask = is_exception_[w]; mask; mask &= mask - 1) {
+                exceptions_[k++] = lcp[w * 64 + std::countr_zero(mask)];
+            }
+        }
+
+        rmq_ = rmq::RMQ<uint8_t, 64, Unsigned>(bytes_.get(), n, threads);
+        exception_rmq_ = rmq::RMQ<Index, 64, Unsigned>(exceptions_.data(), exceptions_.size(), threads);
+    }
+
+    CompactLCP(CompactLCP&&) = default;
+    CompactLCP& operator=(CompactLCP&&) = default;
+
+    CompactLCP(CompactLCP const&) = delete;
+    CompactLCP& operator=(CompactLCP const&) = delete;
+
+    Index operator[](Index const i) const {
+        assert(i < n_);
+        return bytes_[i] < large_ ? Index(bytes_[i]) : exceptions_[rank(i)];
+    }
+
+    // returns the minimum LCP value in [i, j]
+    Index min(Index const i, Index const j) const {
+        assert(i <= j && j < n_);
+        auto const p = rmq_(i, j);
+        if(bytes_[p] < large_) return bytes_[p];
+
+        // all values in the range are exceptions
+        size_t const a = rank(i);
+        assert(rank(j) == a + (j - i));
+        return exceptions_[exception_rmq_(a, a + (j - i))];
+    }
+
+    // prefetches the bytes that a query with the given endpoint scans
+    void prefetch(Index const i) const {
+        rmq_.prefetch(i);
+    }
+
+    Index size() const { return n_; }
+    Index max() const { return max_; }
+    size_t num_exceptions() const { return exceptions_.size(); }
+
+    // reports the space needed, including the RMQs
+    size_t size_in_bytes() const { return size_in_bytes(n_, exceptions_.size()); }
+};
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * decompress.hpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _LZEND_DECOMPRESS_HPP
+#define _LZEND_DECOMPRESS_HPP
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "lzend.hpp"
+
+namespace lzend {
+
+// decompresses a parsing phrase by phrase into a caller-supplied buffer
+//
+// the end positions of the phrases decompressed so far are kept in a caller-supplied array, which must be able to hold one entry per phrase,
+// so that each link can be resolved to its source, which always ends before the current phrase and can thus be copied using memcpy
+// phrases can be passed in arbitrary chunks, e.g., as they are read from a Decoder, and the decompressor can also be used as the sink for parse_blockwise
+template<std::signed_integral Index = int32_t>
+class Decompressor {
+private:
+    char* out_;
+    Index* ends_;
+    size_t pos_;
+    size_t z_;
+
+public:
+    Decompressor(char* out, Index* ends) : out_(out), ends_(ends), pos_(0), z_(0) {
+    }
+
+    // continues decompressing after the given number of characters and phrases, e.g., those of a reference, which are already in out and ends
+    Decompressor(char* out, Index* ends, size_t const pos, size_t const z) : out_(out), ends_(ends), pos_(pos), z_(z) {
+    }
+
+    void operator()(Phrase<Index> const& f) {
+        size_t const copy_len = f.len - 1;
+        if(copy_len > 0) {
+            assert(size_t(f.lnk) < z_);
+            size_t const src_end = size_t(ends_[f.lnk]) + 1;
+            assert(src_end >= copy_len && src_end <= pos_);
+            std::memcpy(out_ + pos_, out_ + src_end - copy_len, copy_len);
+        }
+        out_[pos_ + copy_len] = f.ext;
+        pos_ += f.len;
+        ends_[z_++] = Index(pos_ - 1);
+    }
+
+    void decompress(std::span<Phrase<Index> const> const chunk) {
+        for(auto const& f : chunk) (*this)(f);
+    }
+
+    // the number of characters decompressed so far
+    size_t length() const { return pos_; }
+
+    // the number of phrases decompressed so far
+    size_t num_phrases() const { return z_; }
+};
+
+// computes the length of the text represented by the given parsing
+template<std::signed_integral Index>
+size_t decompressed_length(std::span<Phrase<Index> const> const parsing) {
+    size_t n = 0;
+    for(auto const& f : parsing) n += f.len;
+    return n;
+}
+
+template<std::signed_integral Index>
+size_t decompressed_length(std::vector<Phrase<Index>> const& parsing) {
+    return decompressed_length(std::span<Phrase<Index> const>(parsing));
+}
+
+// decompresses the given parsing into out, which must hold decompressed_length(parsing) characters,
+// using ends as scratch space for the phrase end positions, which must hold one entry per phrase
+template<std::signed_integral Index>
+void decompress(std::span<Phrase<Index> const> const parsing, char* out, Index* ends) {
+    Decompressor<Index>(out, ends).decompress(parsing);
+}
+
+// decompresses the given parsing into out, which must hold decompressed_length(parsing) characters
+template<std::signed_integral Index>
+void decompress(std::span<Phrase<Index> const> const parsing, char* out) {
+    auto ends = std::make_unique_for_overwrite<Index[]>(parsing.size());
+    decompress(parsing, out, ends.get());
+}
+
+// decompresses the given parsing into a string
+template<std::signed_integral Index>
+std::string decompress(std::vector<Phrase<Index>> const& parsing) {
+    std::span<Phrase<Index> const> const span(parsing);
+    std::string s(decompressed_length(span), 0);
+    decompress(span, s.data());
+    return s;
+}
+
+}
+
+#endif
@@ -0,0 +1,178 @@
+/**
+ * elias_fano.hpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _LZEND_ELIAS_FANO_HPP
+#define _LZEND_ELIAS_FANO_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace lzend {
+
+namespace internal {
+
+// finds the position of the r-th (0-based) set bit in x, which must exist
+inline size_t select_in_word(uint64_t x, size_t r) {
+#if defined(__BMI2__)
+    return std::countr_zero(_pdep_u64(1ULL << r, x));
+#else
+    while(r--) x &= x - 1;
+    return std::countr_zero(x);
+#endif
+}
+
+}
+
+// Elias-Fano representation of a non-decreasing sequence of integers
+//
+// each value is split into its lower bits, which are stored in a packed array, and its upper bits, which are stored in unary in a bit vector
+// that is sampled for select queries on both set and unset bits, so that access and successor queries take (practically) constant time
+class EliasFano {
+private:
+    static constexpr size_t sample_rate_ = 256;
+
+    size_t size_;
+    size_t low_bits_;
+    std::vector<uint64_t> low_;
+    std::vector<uint64_t> high_;
+    std::vector<uint64_t> select1_samples_; // position of every sample_rate_-th set bit
+    std::vector<uint64_t> select0_samples_; // position of every sample_rate_-th unset bit
+
+    uint64_t low(size_t const k) const {
+        if(low_bits_ == 0) return 0;
+        size_t const bit = k * low_bits_;
+        size_t const w = bit / 64, b = bit % 64;
+        uint64_t x = low_[w] >> b;
+        if(b + low_bits_ > 64) x |= low_[w + 1] << (64 - b);
+        return x & ((1ULL << low_bits_) - 1);
+    }
+
+    template<bool bit>
+    size_t select(std::vector<uint64_t> const& samples, size_t r) const {
+        size_t pos = samples[r / sample_rate_];
+        r %= sample_rate_;
+
+        size_t w = pos / 64;
+        uint64_t word = (bit ? high_[w] : ~high_[w]) & (UINT64_MAX << (pos % 64));
+        while(true) {
+            size_t const c = std::popcount(word);
+            if(r < c) return w * 64 + internal::select_in_word(word, r);
+            r -= c;
+            ++w;
+            word = bit ? high_[w] : ~high_[w];
+        }
+    }
+
+    // the position of the r-th set bit in the upper bits
+    size_t select1(size_t const r) const { return select<true>(select1_samples_, r); }
+
+    // the position of the r-th unset bit in the upper bits
+    size_t select0(size_t const r) const { return select<false>(select0_samples_, r); }
+
+public:
+    EliasFano() : size_(0), low_bits_(0) {
+    }
+
+    // encodes the given non-decreasing sequence
+    EliasFano(std::span<uint64_t const> const values) : size_(values.size()), low_bits_(0) {
+        uint64_t const universe = size_ > 0 ? values.back() + 1 : 1;
+        if(size_ > 0 && universe > size_) low_bits_ = std::bit_width(universe / size_) - 1;
+
+        low_.resize((size_ * low_bits_ + 63) / 64 + 1, 0);
+        size_t const high_len = size_ + (universe >> low_bits_) + 1;
+        high_.resize(high_len / 64 + 2, 0); // nb: padding, so that select scans never run past the end
+
+        for(size_t k = 0; k < size_; k++) {
+            assert(k == 0 || values[k-1] <= values[k]);
+            uint64_t const x = values[k];
+            if(low_bits_ > 0) {
+                size_t const bit = k * low_bits_;
+                uint64_t const l = x & ((1ULL << low_bits_) - 1);
+                low_[bit / 64] |= l << (bit % 64);
+                if(bit % 64 + low_bits_ > 64) low_[bit / 64 + 1] |= l >> (64 - bit % 64);
+            }
+            size_t const h = (x >> low_bits_) + k;
+            high_[h / 64] |= 1ULL << (h % 64);
+        }
+
+        // sample select positions
+        size_t ones = 0, zeros = 0;
+        for(size_t p = 0; p < high_.size() * 64; p++) {
+            if(high_[p / 64] & (1ULL << (p % 64))) {
+                if(ones++ % sample_rate_ == 0) select1_samples_.push_back(p);
+            } else {
+                if(zeros++ % sample_rate_ == 0) select0_samples_.push_back(p);
+            }
+        }
+    }
+
+    // the number of values
+    size_t size() const { return size_; }
+
+    // the k-th value
+    uint64_t operator[](size_t const k) const {
+        assert(k < size_);
+        return ((select1(k) - k) << low_bits_) | low(k);
+    }
+
+    // finds the index of the first value that is greater than or equal to x, or size() if there is none
+    size_t successor(uint64_t const x) const {
+        if(size_ == 0) return 0;
+        uint64_t const h = x >> low_bits_;
+        if(h > ((*this)[size_ - 1] >> low_bits_)) return size_;
+
+        // the values with upper bits h range from k to k_end (exclusive)
+        size_t k = h > 0 ? select0(h - 1) + 1 - h : 0;
+        size_t k_end = select0(h) - h;
+
+        // binary search the lower bits within the bucket, the next bucket's first value is the fallback
+        uint64_t const l = x & ((1ULL << low_bits_) - 1);
+        while(k < k_end) {
+            size_t const m = k + (k_end - k) / 2;
+            if(low(m) < l) k = m + 1; else k_end = m;
+        }
+        return k;
+    }
+
+    // the size of this data structure in bytes
+    size_t size_in_bytes() const {
+        return (low_.size() + high_.size() + select0_samples_.size() + select1_samples_.size()) * sizeof(uint64_t);
+    }
+};
+
+}
+
+#endif
@@ -0,0 +1,303 @@
+/**
+ * encoding.hpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _LZEND_ENCODING_HPP
+#define _LZEND_ENCODING_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "lzend.hpp"
+
+// binary container format for LZ-End parsings
+//
+// the file starts with the magic bytes "LZE" and a version byte, followed by a sequence of blocks
+// each block consists of the varint-coded number of phrases in the block, the varint-coded byte length of its code stream,
+// the code stream and the phrases' extension characters; a block containing zero phrases terminates the file
+//
+// in the code stream, each phrase is coded as the varint len-1, followed by the varint i-1-lnk of its link relative to its own
+// phrase index i unless len=1 (in which case the phrase is a single literal and the link is omitted)
+// for a parsing computed against a reference (see reference.hpp), phrase indices count the reference's phrases first, which are not stored
+namespace lzend {
+
+namespace internal {
+
+constexpr char encoding_magic[4] = { 'L', 'Z', 'E', 1 };
+
+inline void put_varint(std::string& buf, uint64_t x) {
+    while(x >= 0x80) {
+        buf.push_back(char(x | 0x80));
+        x >>= 7;
+    }
+    buf.push_back(char(x));
+}
+
+// decodes a varint from the buffer and advances p, returns false if the buffer ends prematurely
+inline bool get_varint(char const*& p, char const* const end, uint64_t& x) {
+    x = 0;
+    for(size_t shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t const b = *p++;
+        x |= uint64_t(b & 0x7F) << shift;
+        if(!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+}
+
+// streaming writer for the LZ-End container format
+// phrases are buffered blockwise, so the full parsing is never materialized; the encoder can be used as a sink for parse_blockwise
+template<std::signed_integral Index = int32_t>
+class Encoder {
+private:
+    std::ostream* out_;
+    size_t block_size_;
+    std::string codes_;
+    std::string exts_;
+    size_t first_phrase_;
+    size_t num_phrases_;
+    size_t num_bytes_;
+    bool finished_;
+
+    void write_bytes(char const* data, size_t const n) {
+        out_->write(data, n);
+        num_bytes_ += n;
+    }
+
+    void write_varint(uint64_t const x) {
+        std::string buf;
+        internal::put_varint(buf, x);
+        write_bytes(buf.data(), buf.size());
+    }
+
+    void flush_block() {
+        write_varint(exts_.size());
+        write_varint(codes_.size());
+        write_bytes(codes_.data(), codes_.size());
+        write_bytes(exts_.data(), exts_.size());
+        codes_.clear();
+        exts_.clear();
+    }
+
+public:
+    static constexpr size_t default_block_size = 1ULL << 16;
+
+    // the phrases are numbered starting from the given first phrase, e.g., the number of phrases of a reference
+    Encoder(std::ostream& out, size_t const block_size = default_block_size, size_t const first_phrase = 0)
+        : out_(&out), block_size_(std::max(block_size, size_t(1))), first_phrase_(first_phrase), num_phrases_(0), num_bytes_(0), finished_(false) {
+        write_bytes(internal::encoding_magic, sizeof(internal::encoding_magic));
+    }
+
+    ~Encoder() {
+        finish();
+    }
+
+    Encoder(Encoder const&) = delete;
+    Encoder& operator=(Encoder const&) = delete;
+
+    void write(Phrase<Index> const& f) {
+        assert(!finished_);
+        assert(f.len >= 1);
+        internal::put_varint(codes_, uint64_t(f.len - 1));
+        if(f.len > 1) {
+            assert(size_t(f.lnk) < first_phrase_ + num_phrases_);
+            internal::put_varint(codes_, first_phrase_ + num_phrases_ - 1 - size_t(f.lnk));
+        }
+        exts_.push_back(f.ext);
+        ++num_phrases_;
+
+        if(exts_.size() >= block_size_) flush_block();
+    }
+
+    void operator()(Phrase<Index> const& f) {
+        write(f);
+    }
+
+    // writes the remaining phrases and the terminating block
+    void finish() {
+        if(finished_) return;
+        if(!exts_.empty()) flush_block();
+        flush_block(); // nb: empty terminating block
+        out_->flush();
+        finished_ = true;
+    }
+
+    // the number of phrases written so far
+    size_t num_phrases() const { return num_phrases_; }
+
+    // the number of bytes written to the output so far
+    size_t num_bytes() const { return num_bytes_; }
+};
+
+// streaming reader for the LZ-End container format
+// only a single block is held in memory at any time
+template<std::signed_integral Index = int32_t>
+class Decoder {
+private:
+    std::istream* in_;
+    std::string codes_;
+    std::string exts_;
+    char const* code_pos_;
+    size_t ext_pos_;
+    size_t first_phrase_;
+    size_t num_phrases_;
+    bool good_;
+    bool end_;
+
+    bool read_varint(uint64_t& x) {
+        x = 0;
+        for(size_t shift = 0; shift < 64; shift += 7) {
+            int const c = in_->get();
+            if(c == std::istream::traits_type::eof()) return false;
+            x |= uint64_t(c & 0x7F) << shift;
+            if(!(c & 0x80)) return true;
+        }
+        return false;
+    }
+
+    // the number of bytes left in the input, or the maximum if the stream cannot tell (e.g., a pipe)
+    uint64_t remaining() {
+        auto const pos = in_->tellg();
+        if(pos == std::streampos(-1)) return UINT64_MAX;
+        in_->seekg(0, std::ios::end);
+        auto const end = in_->tellg();
+        in_->seekg(pos);
+        return end >= pos ? uint64_t(end - pos) : 0;
+    }
+
+    // reads n bytes into the buffer, which grows piecewise so that a corrupt length read from a stream that cannot tell
+    // its remaining bytes fails at its end rather than causing a huge allocation
+    bool read_bytes(std::string& buf, uint64_t const n) {
+        static constexpr uint64_t max_piece = 1ULL << 20;
+        buf.clear();
+        while(buf.size() < n) {
+            size_t const offs = buf.size();
+            size_t const m = std::min(n - offs, max_piece);
+            buf.resize(offs + m);
+            in_->read(buf.data() + offs, m);
+            if(!*in_) return false;
+        }
+        return true;
+    }
+
+    bool fail() {
+        good_ = false;
+        end_ = true;
+        return false;
+    }
+
+    bool read_block() {
+        uint64_t num_block_phrases, num_code_bytes;
+        if(!read_varint(num_block_phrases) || !read_varint(num_code_bytes)) return fail();
+        if(num_block_phrases == 0) {
+            if(num_code_bytes != 0) return fail();
+            end_ = true;
+            return false;
+        }
+
+        // each phrase is coded by at least one byte, and the block must fit into the rest of the input
+        if(num_code_bytes < num_block_phrases) return fail();
+        uint64_t const num_remaining = remaining();
+        if(num_code_bytes > num_remaining || num_block_phrases > num_remaining - num_code_bytes) return fail();
+        if(!read_bytes(codes_, num_code_bytes) || !read_bytes(exts_, num_block_phrases)) return fail();
+
+        code_pos_ = codes_.data();
+        ext_pos_ = 0;
+        return true;
+    }
+
+public:
+    // the phrases are numbered starting from the given first phrase, which must be the one the encoder started from
+    Decoder(std::istream& in, size_t const first_phrase = 0) : in_(&in), code_pos_(nullptr), ext_pos_(0), first_phrase_(first_phrase), num_phrases_(0), good_(true), end_(false) {
+        char magic[sizeof(internal::encoding_magic)];
+        in_->read(magic, sizeof(magic));
+        good_ = bool(*in_) && std::equal(magic, magic + sizeof(magic), internal::encoding_magic);
+        end_ = !good_;
+    }
+
+    Decoder(Decoder const&) = delete;
+    Decoder& operator=(Decoder const&) = delete;
+
+    // reads the next phrase, returns false at the end of the parsing or if the input is malformed
+    // the links of single literal phrases are reported as zero
+    bool read(Phrase<Index>& f) {
+        if(end_) return false;
+        if(ext_pos_ >= exts_.size() && !read_block()) return false;
+
+        char const* const code_end = codes_.data() + codes_.size();
+        uint64_t len_minus_one, lnk_delta = 0;
+        if(!internal::get_varint(code_pos_, code_end, len_minus_one)) return fail();
+        if(len_minus_one > 0) {
+            if(!internal::get_varint(code_pos_, code_end, lnk_delta) || lnk_delta >= first_phrase_ + num_phrases_) return fail();
+        }
+
+        f.lnk = len_minus_one > 0 ? Index(first_phrase_ + num_phrases_ - 1 - lnk_delta) : 0;
+        f.len = Index(len_minus_one + 1);
+        f.ext = exts_[ext_pos_++];
+        ++num_phrases_;
+
+        // the code stream must be consumed exactly by the block's phrases
+        if((ext_pos_ == exts_.size()) != (code_pos_ == code_end)) return fail();
+        return true;
+    }
+
+    // tells whether the input has been well-formed so far
+    bool good() const { return good_; }
+
+    // the number of phrases read so far
+    size_t num_phrases() const { return num_phrases_; }
+};
+
+// encodes the given parsing, whose phrases are numbered starting from the given first phrase, to the output stream and returns the number of bytes written
+template<std::signed_integral Index>
+size_t encode(std::ostream& out, std::vector<Phrase<Index>> const& parsing, size_t const first_phrase = 0) {
+    Encoder<Index> enc(out, Encoder<Index>::default_block_size, first_phrase);
+    for(auto const& f : parsing) enc.write(f);
+    enc.finish();
+    return enc.num_bytes();
+}
+
+// decodes a parsing, whose phrases are numbered starting from the given first phrase, from the input stream; the result is empty if the input is malformed
+template<std::signed_integral Index = int32_t>
+std::vector<Phrase<Index>> decode(std::istream& in, size_t const first_phrase = 0) {
+    std::vector<Phrase<Index>> parsing;
+    Decoder<Index> dec(in, first_phrase);
+    Phrase<Index> f;
+    while(dec.read(f)) parsing.push_back(f);
+    if(!dec.good()) parsing.clear();
+    return parsing;
+}
+
+}
+
+#endif
@@ -27,31 +27,223 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 
+#include <filesystem>
 #include <fstream>
 #include <memory>
+#include <stdexcept>
+#include <string>
 
+#include "encoding.hpp"
 #include "lzend.hpp"
+#include "mapped_file.hpp"
+#include "reference.hpp"
 
-
+// parses a size argument with an optional K, M or G suffix
+size_t parse_size(std::string const& arg) {
+    size_t pos;
+    size_t x = std::stoull(arg, &pos);
+    if(pos < arg.length()) {
+        switch(arg[pos]) {
+            case 'G': case 'g': x <<= 10; [[fallthrough]];
+            case 'M': case 'm': x <<= 10; [[fallthrough]];
+            case 'K': case 'k': x <<= 10; break;
+        }
+    }
+    return x;
+}
 
 int main(int argc, char** argv) {
-    if(argc < 2) {
-        std::cerr << "usage: " << argv[0] << " [FILE]" << std::endl;
+    std::string file;
+    std::string output;
+    std::string reference;
+    std::string reference_output;
+    size_t window = 0;
+    bool print_stats = false;
+    lzend::Options options;
+    options.print_progress = true;
+    for(int i = 1; i < argc; i++) {
+        std::string const arg = argv[i];
+        if(arg == "-w" && i + 1 < argc) {
+            window = parse_size(argv[++i]);
+        } else if(arg == "-t" && i + 1 < argc) {
+            options.threads = std::stoi(argv[++i]);
+        } else if(arg == "-o" && i + 1 < argc) {
+            output = argv[++i];
+        } else if(arg == "-c" && i + 1 < argc) {
+            options.num_chunks = std::stoull(argv[++i]);
+        } else if(arg == "-k" && i + 1 < argc) {
+            options.checkpoint_dir = argv[++i];
+        } else if(arg == "-K" && i + 1 < argc) {
+            options.checkpoint_interval = parse_size(argv[++i]);
+        } else if(arg == "-p") {
+            options.pipeline = true;
+        } else if(arg == "-I" && i + 1 < argc) {
+            options.max_rmq_interval = parse_size(argv[++i]);
+        } else if(arg == "-L" && i + 1 < argc) {
+            options.max_phrase_len = parse_size(argv[++i]);
+        } else if(arg == "-q") {
+            options.requery = false;
+        } else if(arg == "-l") {
+            options.compact_lcp = true;
+        } else if(arg == "-m") {
+            options.low_memory = true;
+        } else if(arg == "-r" && i + 1 < argc) {
+            reference = argv[++i];
+        } else if(arg == "-R" && i + 1 < argc) {
+            reference_output = argv[++i];
+        } else if(arg == "-s") {
+            print_stats = true;
+        } else {
+            file = arg;
+        }
+    }
+
+    if(file.empty()) {
+        std::cerr << "usage: " << argv[0] << " [-w WINDOW] [-t THREADS] [-c CHUNKS] [-k DIR] [-K INTERVAL] [-p] [-l] [-I INTERVAL] [-L LENGTH] [-q] [-m] [-r REFERENCE] [-R REFERENCE] [-s] [-o OUTPUT] [FILE]" << std::endl;
+        std::cerr << "\t-w WINDOW\tparse blockwise in windows of the given size (e.g., 512M)" << std::endl;
+        std::cerr << "\t-t THREADS\tnumber of threads for SA and LCP construction (0 for all available)" << std::endl;
+        std::cerr << "\t-c CHUNKS\tparse the given number of chunks in parallel (0 for one per thread)" << std::endl;
+        std::cerr << "\t-k DIR\t\tcheckpoint to the given directory and resume from it if interrupted" << std::endl;
+        std::cerr << "\t-K INTERVAL\tnumber of input characters between checkpoint snapshots (default: 256M)" << std::endl;
+        std::cerr << "\t-p\t\tbuild the RMQ and the permuted ISA concurrently" << std::endl;
+        std::cerr << "\t-l\t\tparse using a compact LCP array with most values stored in a single byte" << std::endl;
+        std::cerr << "\t-I INTERVAL\tbounded latency: do not consider sources beyond the given RMQ interval length" << std::endl;
+        std::cerr << "\t-L LENGTH\tbounded latency: limit phrases to the given length" << std::endl;
+        std::cerr << "\t-q\t\tbounded latency: do not query source candidates again" << std::endl;
+        std::cerr << "\t-m\t\tlow-memory construction (slower)" << std::endl;
+        std::cerr << "\t-r REFERENCE\tparse against the given reference dictionary, so phrases may copy from it" << std::endl;
+        std::cerr << "\t-R REFERENCE\tstore the input and its parsing as a reference dictionary to the given file" << std::endl;
+        std::cerr << "\t-s\t\tprint statistics as JSON" << std::endl;
+        std::cerr << "\t-o OUTPUT\twrite the encoded parsing to the given file" << std::endl;
+        return -1;
+    }
+
+    if(options.threads != 1 && !lzend::supports_openmp) {
+        std::cerr << "warning: built without OpenMP support, using a single thread" << std::endl;
+    }
+
+    if(window > 0 && (!reference.empty() || !reference_output.empty())) {
+        std::cerr << "reference dictionaries cannot be used when parsing blockwise" << std::endl;
         return -1;
     }
-    
-    // load input file
-    std::string s;
-    {
-        std::ifstream ifs(argv[1]);
-        s = std::string(std::istreambuf_iterator<char>(ifs), {});
-    }
-    
-    // parse
-    auto const t0 = timestamp();
-    auto const z = lzend::parse(s, true).size();
-    auto const dt = timestamp() - t0;
-    std::cout << "-> z=" << z << std::endl;
-    return 0;
+
+    // load the reference dictionary, if any
+    lzend::Reference ref;
+    if(!reference.empty()) {
+        ref = lzend::Reference(reference);
+        if(!ref.good()) {
+            std::cerr << "failed to load reference dictionary: " << reference << std::endl;
+            return -1;
+        }
+    }
+
+    std::ofstream ofs;
+    if(!output.empty()) {
+        ofs.open(output, std::ios::binary);
+        if(!ofs) {
+            std::cerr << "failed to open output file: " << output << std::endl;
+            return -1;
+        }
+    }
+
+    // reports the size of the encoding relative to the input
+    auto report_encoding = [](size_t const bytes, size_t const n){
+        std::cout << "-> encoded: " << bytes << " bytes (" << (100.0 * bytes / std::max(n, size_t(1))) << "% of input)";
+    };
+
+    // prints the statistics if they have been collected
+    auto print = [](auto const& stats){
+        if constexpr(std::remove_cvref_t<decltype(stats)>::enabled) {
+            stats.print_json(std::cout);
+            std::cout << std::endl;
+        }
+    };
+
+    // parses the input, collecting statistics using the given policy
+    auto run = [&](auto& stats) -> int {
+        if(window > 0) {
+            // parse blockwise, streaming the input and, if requested, the encoded output
+            std::ifstream ifs(file);
+            size_t z;
+            if(ofs.is_open()) {
+                lzend::Encoder<int64_t> enc(ofs);
+                z = lzend::parse_blockwise<int64_t>(ifs, window, enc, options, stats);
+                enc.finish();
+                report_encoding(enc.num_bytes(), std::filesystem::file_size(file));
+                std::cout << std::endl;
+            } else {
+                z = lzend::parse_blockwise<int64_t>(ifs, window, [](lzend::Phrase<int64_t> const&){}, options, stats);
+            }
+            std::cout << "-> z=" << z << ", peak memory: " << (lzend::peak_memory() >> 20) << " MiB" << std::endl;
+            print(stats);
+            return 0;
+        }
+
+        // map input file
+        lzend::MappedFile input(file);
+        if(!input.good()) {
+            std::cerr << "failed to map input file: " << file << std::endl;
+            return -1;
+        }
+        auto const s = input.view();
+
+        // parses the input, streaming the phrases into the encoder or storing it as a reference if requested, and returns the number of phrases
+        bool failed = false;
+        auto process = [&]<typename Index>() -> size_t {
+            if(!reference_output.empty()) {
+                auto const new_ref = lzend::Reference::compute<Index>(s, options, stats);
+                if(!new_ref.save(reference_output)) {
+                    std::cerr << "failed to write reference dictionary: " << reference_output << std::endl;
+                    failed = true;
+                }
+                return new_ref.num_phrases();
+            }
+
+            auto parse = [&](auto&& sink){
+                return ref.size() > 0 ? lzend::parse<Index>(s, ref, sink, options, stats) : lzend::parse<Index>(s, sink, options, stats);
+            };
+            if(ofs.is_open()) {
+                lzend::Encoder<Index> enc(ofs, lzend::Encoder<Index>::default_block_size, ref.num_phrases());
+                auto const z = parse(enc);
+                enc.finish();
+                report_encoding(enc.num_bytes(), s.length());
+                std::cout << std::endl;
+                return z;
+            }
+            return parse([](lzend::Phrase<Index> const&){});
+        };
+
+        // parse, using 64-bit indices only if necessary
+        // nb: the phrases are numbered after those of the reference, but the input's positions do not depend on it
+        size_t z;
+        try {
+            if(ref.num_phrases() + s.length() <= size_t(INT32_MAX)) {
+                z = process.template operator()<int32_t>();
+            } else {
+#ifdef LZEND_LIBSAIS64
+                z = process.template operator()<int64_t>();
+#else
+                std::cerr << "inputs beyond 2 GiB require libsais64; consider using -w" << std::endl;
+                return -1;
+#endif
+            }
+        } catch(std::length_error const& e) {
+            std::cerr << e.what() << std::endl;
+            return -1;
+        }
+        if(failed) return -1;
+        std::cout << "-> z=" << z << ", peak memory: " << (lzend::peak_memory() >> 20) << " MiB" << std::endl;
+        print(stats);
+        return 0;
+    };
+
+    if(print_stats) {
+        lzend::Stats stats;
+        return run(stats);
+    } else {
+        lzend::NoStats stats;
+        return run(stats);
+    }
 }
@@ -30,165 +30,1478 @@
 
 #include "libsais.h"
 
+// inputs beyond 2 GiB are supported if libsais64 is available, which the build detects and signals by defining LZEND_LIBSAIS64
+#ifdef LZEND_LIBSAIS64
+#include "libsais64.h"
+#endif
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
 #include <chrono>
+#include <climits>
+#include <concepts>
 #include <cstdint>
+#include <cstring>
 #include <iostream>
-#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include <rmq/rmq.hpp>
 #include <ordered/btree/map.hpp>
+#include <ordered/bit_trie/map.hpp>
+#include <ordered/range_marking/map.hpp>
 
-uintmax_t timestamp() {
-    return std::chrono::system_clock::now().time_since_epoch() / std::chrono::milliseconds(1);
-}
+#include "checkpoint.hpp"
+#include "compact_lcp.hpp"
+#include "stats.hpp"
 
 namespace lzend {
 
-using Index = int32_t;
+// tells whether inputs beyond 2 GiB can be parsed; 64-bit indices can always be used, but without libsais64,
+// the suffix and LCP arrays are constructed using 32-bit indices, which limits the input length to INT32_MAX
+#ifdef LZEND_LIBSAIS64
+constexpr bool supports_64bit = true;
+#else
+constexpr bool supports_64bit = false;
+#endif
 
-// represents an LZ-End phrase
+#ifdef LIBSAIS_OPENMP
+constexpr bool supports_openmp = true;
+#else
+constexpr bool supports_openmp = false;
+#endif
+
+// represents an LZ-End phrase, whose extension symbol is a character unless parsing a sequence of integer symbols
+template<std::signed_integral Index = int32_t, typename Symbol = char>
 struct Phrase {
-    Index lnk;
-    Index len;
-    char  ext;
+    Index  lnk;
+    Index  len;
+    Symbol ext;
 };
 
-// computes the LZ-End parsing and returns the number of phrases
-std::vector<Phrase> parse(std::string const& s, bool print_progress = false) {
-    Index const n = s.length();
-    if(print_progress) std::cout << "LZ-End input: n=" << n << std::endl;
+// the integer types that can be parsed as symbols in addition to bytes
+template<typename Symbol>
+concept IntegerSymbol = std::integral<Symbol> && sizeof(Symbol) > 1 && sizeof(Symbol) <= 8;
+
+namespace internal {
 
-    // reverse text
-    std::string rs = s;
-    std::reverse(rs.begin(), rs.end());
+// suffix and LCP array construction dispatched by index width
+// if libsais was built with OpenMP support, the parallel variants are used for any thread count other than one
 
-    uintmax_t t0, ttotal0;
+// a context, if given, holds libsais's working memory so it can be reused across inputs
+inline void compute_sa(uint8_t const* t, int32_t* sa, int32_t const n, int const threads, void const* ctx = nullptr) {
+    if(ctx) { libsais_ctx(ctx, t, sa, n, 0, nullptr); return; }
+#ifdef LIBSAIS_OPENMP
+    if(threads != 1) { libsais_omp(t, sa, n, 0, nullptr, threads); return; }
+#endif
+    libsais(t, sa, n, 0, nullptr);
+}
 
-    // construct suffix array
-    if(print_progress) { std::cout << "\tcompute SA ...\t\t\t"; std::cout.flush(); } 
-    t0 = timestamp();
-    ttotal0 = timestamp();
+inline void compute_plcp(uint8_t const* t, int32_t const* sa, int32_t* plcp, int32_t const n, int const threads) {
+#ifdef LIBSAIS_OPENMP
+    if(threads != 1) { libsais_plcp_omp(t, sa, plcp, n, threads); return; }
+#endif
+    libsais_plcp(t, sa, plcp, n);
+}
 
-    auto sa = std::make_unique<Index[]>(n);
-    libsais((uint8_t const*)rs.data(), sa.get(), n, 0, nullptr);
+inline void compute_lcp(int32_t const* plcp, int32_t const* sa, int32_t* lcp, int32_t const n, int const threads) {
+#ifdef LIBSAIS_OPENMP
+    if(threads != 1) { libsais_lcp_omp(plcp, sa, lcp, n, threads); return; }
+#endif
+    libsais_lcp(plcp, sa, lcp, n);
+}
 
-    if(print_progress) std::cout << timestamp() - t0 << " ms" << std::endl;
-    
-    // construct PLCP array and the LCP array from it
-    if(print_progress) { std::cout << "\tcompute LCP ...\t\t\t"; std::cout.flush(); }
-    t0 = timestamp();
+// for integer texts over the alphabet [0, k), which libsais modifies during construction, but restores afterwards
+inline void compute_sa(int32_t* t, int32_t* sa, int32_t const n, int32_t const k, int const threads) {
+#ifdef LIBSAIS_OPENMP
+    if(threads != 1) { libsais_int_omp(t, sa, n, k, 0, threads); return; }
+#endif
+    libsais_int(t, sa, n, k, 0);
+}
 
-    auto isa = std::make_unique<Index[]>(n);
-    auto& plcp = isa;
-    libsais_plcp((uint8_t const*)rs.data(), sa.get(), isa.get(), n);
-    
-    auto lcp = std::make_unique<Index[]>(n);
-    libsais_lcp(plcp.get(), sa.get(), lcp.get(), n);
+inline void compute_plcp(int32_t const* t, int32_t const* sa, int32_t* plcp, int32_t const n, int const threads) {
+#ifdef LIBSAIS_OPENMP
+    if(threads != 1) { libsais_plcp_int_omp(t, sa, plcp, n, threads); return; }
+#endif
+    libsais_plcp_int(t, sa, plcp, n);
+}
 
-    if(print_progress) std::cout << timestamp() - t0 << " ms" << std::endl;
-    
-    // construct RMQ data structure
-    if(print_progress) { std::cout << "\tcompute RMQ ...\t\t\t"; std::cout.flush(); }
-    t0 = timestamp();
+#ifdef LZEND_LIBSAIS64
+inline void compute_sa(uint8_t const* t, int64_t* sa, int64_t const n, int const threads) {
+#ifdef LIBSAIS_OPENMP
+    if(threads != 1) { libsais64_omp(t, sa, n, 0, nullptr, threads); return; }
+#endif
+    libsais64(t, sa, n, 0, nullptr);
+}
 
-    rmq::RMQ<Index> rmq(lcp.get(), n);
+inline void compute_plcp(uint8_t const* t, int64_t const* sa, int64_t* plcp, int64_t const n, int const threads) {
+#ifdef LIBSAIS_OPENMP
+    if(threads != 1) { libsais64_plcp_omp(t, sa, plcp, n, threads); return; }
+#endif
+    libsais64_plcp(t, sa, plcp, n);
+}
 
-    if(print_progress) std::cout << timestamp() - t0 << " ms" << std::endl;
-    
-    // construct permuted inverse suffix array
-    if(print_progress) { std::cout << "\tcompute permuted ISA ...\t"; std::cout.flush(); }
-    t0 = timestamp();
+inline void compute_lcp(int64_t const* plcp, int64_t const* sa, int64_t* lcp, int64_t const n, int const threads) {
+#ifdef LIBSAIS_OPENMP
+    if(threads != 1) { libsais64_lcp_omp(plcp, sa, lcp, n, threads); return; }
+#endif
+    libsais64_lcp(plcp, sa, lcp, n);
+}
 
-    for(Index i = 0; i < n; i++) isa[n-sa[i]-1] = i;
+inline void compute_sa(int64_t* t, int64_t* sa, int64_t const n, int64_t const k, int const threads) {
+#ifdef LIBSAIS_OPENMP
+    if(threads != 1) { libsais64_long_omp(t, sa, n, k, 0, threads); return; }
+#endif
+    libsais64_long(t, sa, n, k, 0);
+}
+
+inline void compute_plcp(int64_t const* t, int64_t const* sa, int64_t* plcp, int64_t const n, int const threads) {
+#ifdef LIBSAIS_OPENMP
+    if(threads != 1) { libsais64_plcp_long_omp(t, sa, plcp, n, threads); return; }
+#endif
+    libsais64_plcp_long(t, sa, plcp, n);
+}
+#else
+// without libsais64, arrays with 64-bit indices are constructed by running libsais in place on their first halves,
+// narrowing the 64-bit values before and widening the 32-bit results afterwards
+// nb: the elements are accessed via memcpy, because both views of the same memory are accessed in the same loop
+inline int32_t* narrow(int64_t* a, int64_t const n) {
+    auto const a32 = (char*)a;
+    for(int64_t i = 0; i < n; i++) {
+        int32_t const x = int32_t(a[i]);
+        std::memcpy(a32 + i * sizeof(int32_t), &x, sizeof(int32_t));
+    }
+    return (int32_t*)a;
+}
+
+inline void widen(int64_t* a, int64_t const n) {
+    auto const a32 = (char const*)a;
+    for(int64_t i = n - 1; i >= 0; i--) {
+        int32_t x;
+        std::memcpy(&x, a32 + i * sizeof(int32_t), sizeof(int32_t));
+        a[i] = x;
+    }
+}
+
+inline void compute_sa(uint8_t const* t, int64_t* sa, int64_t const n, int const threads) {
+    assert(n <= INT32_MAX);
+    compute_sa(t, (int32_t*)sa, int32_t(n), threads);
+    widen(sa, n);
+}
+
+// nb: the suffix array is modified during construction, but restored afterwards
+inline void compute_plcp(uint8_t const* t, int64_t* sa, int64_t* plcp, int64_t const n, int const threads) {
+    compute_plcp(t, narrow(sa, n), (int32_t*)plcp, int32_t(n), threads);
+    widen(plcp, n);
+    widen(sa, n);
+}
+
+// nb: the PLCP and suffix arrays are modified during construction, but restored afterwards
+inline void compute_lcp(int64_t* plcp, int64_t* sa, int64_t* lcp, int64_t const n, int const threads) {
+    compute_lcp(narrow(plcp, n), narrow(sa, n), (int32_t*)lcp, int32_t(n), threads);
+    widen(lcp, n);
+    widen(sa, n);
+    widen(plcp, n);
+}
+
+// nb: the text is modified during construction, but restored afterwards
+inline void compute_sa(int64_t* t, int64_t* sa, int64_t const n, int64_t const k, int const threads) {
+    assert(n <= INT32_MAX && k <= INT32_MAX);
+    compute_sa(narrow(t, n), (int32_t*)sa, int32_t(n), int32_t(k), threads);
+    widen(sa, n);
+    widen(t, n);
+}
+
+// nb: the text and the suffix array are modified during construction, but restored afterwards
+inline void compute_plcp(int64_t* t, int64_t* sa, int64_t* plcp, int64_t const n, int const threads) {
+    compute_plcp(narrow(t, n), narrow(sa, n), (int32_t*)plcp, int32_t(n), threads);
+    widen(plcp, n);
+    widen(sa, n);
+    widen(t, n);
+}
+#endif
+
+// reverses the given integer text into the given buffer, mapping its symbols to the alphabet [0, k) expected by libsais, and returns k
+// if the symbols span a range no larger than the text, they are merely shifted, otherwise they are replaced by their ranks
+template<std::signed_integral Index, IntegerSymbol Symbol>
+Index reverse_text(std::span<Symbol const> const s, Index* rs) {
+    Index const n = s.size();
+    auto const [min, max] = std::minmax_element(s.begin(), s.end());
+    uint64_t const range = uint64_t(*max) - uint64_t(*min); // nb: modular arithmetic also works for signed symbols
+    if(range < uint64_t(n)) {
+        for(Index i = 0; i < n; i++) rs[n-1-i] = Index(uint64_t(s[i]) - uint64_t(*min));
+        return Index(range + 1);
+    }
+
+    std::vector<Symbol> alphabet(s.begin(), s.end());
+    std::sort(alphabet.begin(), alphabet.end());
+    alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+    for(Index i = 0; i < n; i++) rs[n-1-i] = Index(std::lower_bound(alphabet.begin(), alphabet.end(), s[i]) - alphabet.begin());
+    return Index(alphabet.size());
+}
+
+}
+
+// parsing options
+struct Options {
+    // print progress and per-phase timings to stdout
+    bool print_progress = false;
+
+    // number of threads used for the construction of SA, LCP, RMQ and permuted ISA if OpenMP is enabled (zero means OpenMP default)
+    int threads = 1;
+
+    // compute the LCP array and the permuted ISA in place over the PLCP and suffix arrays, respectively,
+    // reducing the peak memory to about (2 * sizeof(Index) + 1) * n bytes at the cost of construction speed
+    bool low_memory = false;
+
+    // split the input into the given number of chunks (zero means one per thread), which are parsed in parallel,
+    // such that phrases of a chunk can only refer to phrases of the same chunk, which increases the number of phrases
+    // the shared data structures are built only once, but each chunk uses its own predecessor data structure,
+    // which universe-based structures cover only the chunk's ranks, renumbering them at the cost of 2 * sizeof(Index) bytes per character
+    size_t num_chunks = 1;
+
+    // when parsing in chunks, merge phrases across chunk boundaries where possible
+    bool repair_boundaries = true;
+
+    // if not empty, the LCP array and the permuted ISA as well as periodic snapshots of the parsing are stored in the given directory,
+    // so that an interrupted parse of the same input can resume from there; the files are removed once the parse is complete
+    // snapshots are only taken when parsing in a single chunk
+    std::string checkpoint_dir;
+
+    // the number of input characters parsed between two snapshots
+    size_t checkpoint_interval = size_t(1) << 28;
+
+    // build the RMQ on an additional thread while the permuted ISA is being built, splitting the threads between the two
+    bool pipeline = false;
+
+    // for the parsing loop, replace the LCP array and the RMQ over it by a lzend::CompactLCP, which stores most values in a single byte,
+    // reducing the working set of the parsing loop, including the RMQs, from about (2 * sizeof(Index) + 1) * n to about (sizeof(Index) + 2.5) * n bytes
+    // on repetitive inputs, at the cost of somewhat slower queries; the RMQ type is then ignored
+    bool compact_lcp = false;
+
+    // bounded-latency parsing, where each of the following limits bounds the work per input character at the cost of more phrases,
+    // and the number of times each limit applied is reported to the statistics policy
+    // the maximum length of an RMQ interval, beyond which a marked phrase is not considered as a source (zero means unlimited)
+    size_t max_rmq_interval = 0;
+
+    // if a source candidate is the phrase preceding the latest one, which cannot be the source of their merger,
+    // query the next candidate in the same direction; otherwise, the two phrases are not merged using that direction
+    bool requery = true;
+
+    // the maximum length of a phrase (zero means unlimited)
+    size_t max_phrase_len = 0;
+};
+
+namespace internal {
+
+// resolves the number of threads to use
+inline int num_threads(Options const& options) {
+    int threads = options.threads;
+#ifdef _OPENMP
+    if(threads <= 0) threads = omp_get_max_threads();
+#endif
+    return threads;
+}
+
+// an array that only ever grows, so it keeps its memory when it is reused for a shorter input
+template<typename T>
+class Buffer {
+private:
+    std::unique_ptr<T[]> data_;
+    size_t capacity_ = 0;
+
+public:
+    // makes room for n entries, whose values are unspecified, and returns the array
+    T* reserve(size_t const n) {
+        if(n > capacity_) {
+            data_.reset();
+            data_ = std::make_unique_for_overwrite<T[]>(n);
+            capacity_ = n;
+        }
+        return data_.get();
+    }
+
+    void reset() {
+        data_.reset();
+        capacity_ = 0;
+    }
+
+    T* get() const { return data_.get(); }
+    size_t capacity() const { return capacity_; }
+
+    friend void swap(Buffer& a, Buffer& b) {
+        std::swap(a.data_, b.data_);
+        std::swap(a.capacity_, b.capacity_);
+    }
+};
+
+// the working memory of a parse, which is released as soon as it is no longer needed unless it is retained for subsequent parses
+template<std::signed_integral Index, typename Marked, typename Symbol = char>
+struct Workspace {
+    bool retain = false;
+    Buffer<uint8_t> text; // the reversed text of bytes
+    Buffer<Index> int_text; // the reversed integer text
+    Buffer<Index> sa, isa, lcp;
+    std::optional<Marked> marked;
+    std::vector<Phrase<Index, Symbol>> parsing;
+    void* sa_ctx = nullptr; // a libsais context for byte texts and 32-bit indices, owned by whoever retains the workspace
+
+    void release(Buffer<uint8_t>& b) { if(!retain) b.reset(); }
+    void release(Buffer<Index>& b) { if(!retain) b.reset(); }
+
+    // releases all memory except for the libsais context
+    void release_all() {
+        text.reset();
+        int_text.reset();
+        sa.reset();
+        isa.reset();
+        lcp.reset();
+        marked.reset();
+        parsing = std::vector<Phrase<Index, Symbol>>();
+    }
+};
+
+// inverts the given permutation in place, using the sign bit to mark processed entries
+template<std::signed_integral Index>
+void invert_permutation(Index* p, Index const n) {
+    for(Index i = 0; i < n; i++) {
+        if(p[i] < 0) continue; // already processed
+
+        Index prev = i;
+        Index cur = p[i];
+        while(cur != i) {
+            Index const next = p[cur];
+            p[cur] = ~prev;
+            prev = cur;
+            cur = next;
+        }
+        p[i] = ~prev;
+    }
+    for(Index i = 0; i < n; i++) p[i] = ~p[i];
+}
+
+// moves each a[i] to a[p[i]] in place, temporarily using the sign bit of p to mark processed entries
+template<std::signed_integral Index>
+void apply_permutation(Index* a, Index* p, Index const n) {
+    for(Index i = 0; i < n; i++) {
+        if(p[i] < 0) continue; // already processed
+
+        Index val = a[i];
+        Index cur = i;
+        do {
+            Index const dst = p[cur];
+            p[cur] = ~dst;
+            std::swap(val, a[dst]);
+            cur = dst;
+        } while(cur != i);
+    }
+    for(Index i = 0; i < n; i++) p[i] = ~p[i];
+}
+
+// computes the permuted ISA, isa[n-sa[i]-1] = i, overwriting the suffix array
+//
+// instead of scattering directly, which causes a cache miss for almost every write, the suffix array is processed in rounds;
+// in each round, the positions are partitioned into a buffer by the block of their destination and then scattered block by block,
+// so the random writes stay within a cache-sized block of the ISA
+// the buffer is the part of the suffix array processed in the previous rounds, so the rounds double in size and no extra memory is needed;
+// the first round, for which there is no buffer yet, scatters directly
+template<std::signed_integral Index>
+void permute_isa(Index* sa, Index* isa, Index const n, int const threads) {
+    size_t const first_round = std::min(std::max(size_t(n) / 16, size_t(1)), size_t(n));
+    #pragma omp parallel for num_threads(threads) if(threads > 1)
+    for(Index i = 0; i < Index(first_round); i++) isa[n-sa[i]-1] = i;
+
+    // blocks of 64 Ki entries, but no more than 4096 blocks, which keeps the partitioning's write cursors in cache
+    int block_bits = 16;
+    while((size_t(n) >> block_bits) >= 4096) ++block_bits;
+    size_t const num_blocks = ((size_t(n) - 1) >> block_bits) + 1;
+
+    Index* const buf = sa;
+    std::vector<size_t> bucket(num_blocks);
+    for(size_t r0 = first_round; r0 < size_t(n); r0 *= 2) {
+        size_t const r1 = std::min(2 * r0, size_t(n));
+
+        // count the positions of each destination block
+        std::fill(bucket.begin(), bucket.end(), 0);
+        for(size_t i = r0; i < r1; i++) ++bucket[size_t(n - sa[i] - 1) >> block_bits];
+
+        // partition the positions into the buffer
+        size_t sum = 0;
+        for(size_t b = 0; b < num_blocks; b++) {
+            auto const c = bucket[b];
+            bucket[b] = sum;
+            sum += c;
+        }
+        for(size_t i = r0; i < r1; i++) buf[bucket[size_t(n - sa[i] - 1) >> block_bits]++] = i;
+
+        // scatter block by block, where block b's positions now end where those of block b+1 begin
+        #pragma omp parallel for num_threads(threads) if(threads > 1) schedule(dynamic, 16)
+        for(size_t b = 0; b < num_blocks; b++) {
+            for(size_t k = (b > 0 ? bucket[b-1] : 0); k < bucket[b]; k++) {
+                Index const i = buf[k];
+                isa[n-sa[i]-1] = i;
+            }
+        }
+    }
+}
+
+// the limits of the bounded-latency parsing, see Options, where the lengths are at most the input length if unlimited
+template<std::signed_integral Index>
+struct Limits {
+    Index max_rmq_interval;
+    bool requery;
+    Index max_phrase_len;
+
+    Limits(Options const& options, Index const n)
+        : max_rmq_interval(options.max_rmq_interval > 0 ? Index(std::min(options.max_rmq_interval, size_t(n))) : n),
+          requery(options.requery),
+          max_phrase_len(options.max_phrase_len > 0 ? Index(std::min(options.max_phrase_len, size_t(n))) : n) {
+    }
+};
+
+// the LCP array together with an RMQ over it, answering range minimum queries like CompactLCP
+template<std::signed_integral Index, typename RMQ>
+struct LCPWithRMQ {
+    Index const* lcp;
+    RMQ const& rmq;
+
+    Index min(Index const i, Index const j) const {
+        return lcp[rmq(i, j)];
+    }
+
+    void prefetch(Index const i) const {
+        if constexpr(requires { rmq.prefetch(i); }) rmq.prefetch(i);
+    }
+};
+
+// the LCP array as seen from a range of positions whose ranks are renumbered in their lexicographic order, so that a universe-based
+// predecessor data structure for the range only needs to cover the range rather than the whole input (see local_ranks)
+template<std::signed_integral Index, typename LCP>
+struct LocalLCP {
+    LCP const& lcp;
+    std::span<Index const> global; // the global rank of each local rank, ascending
+
+    Index min(Index const i, Index const j) const {
+        return lcp.min(global[i-1] + 1, global[j]);
+    }
+
+    void prefetch(Index const i) const {
+        lcp.prefetch(global[i]);
+    }
+
+    Index global_rank(Index const x) const { return global[x]; }
+    Index num_ranks() const { return global.size(); }
+};
+
+// renumbers the ranks of the positions [b, e) in their lexicographic order,
+// returning the global rank of each local rank and the local rank of each position
+template<std::signed_integral Index>
+std::pair<std::vector<Index>, std::vector<Index>> local_ranks(Index const* isa, Index const b, Index const e) {
+    // sort the positions by their ranks using an LSD radix sort, packing each rank together with the position into a single word
+    using Pair = std::conditional_t<sizeof(Index) <= 4, uint64_t, unsigned __int128>;
+    constexpr size_t bits = 8 * sizeof(Index);
+    constexpr size_t digit_bits = 11;
+    Index const m = e - b;
+    std::vector<Pair> by_rank(m), buf(m);
+    Index max_rank = 0;
+    for(Index i = 0; i < m; i++) {
+        by_rank[i] = (Pair(isa[b + i]) << bits) | Pair(i);
+        max_rank = std::max(max_rank, isa[b + i]);
+    }
+    for(size_t shift = bits; shift < bits + std::bit_width(std::make_unsigned_t<Index>(max_rank)); shift += digit_bits) {
+        std::array<size_t, size_t(1) << digit_bits> count = {};
+        for(auto const x : by_rank) ++count[size_t(x >> shift) & (count.size() - 1)];
+        for(size_t d = 0, sum = 0; d < count.size(); d++) sum += std::exchange(count[d], sum);
+        for(auto const x : by_rank) buf[count[size_t(x >> shift) & (count.size() - 1)]++] = x;
+        std::swap(by_rank, buf);
+    }
+    buf = std::vector<Pair>();
+
+    std::vector<Index> global(m), local(m);
+    for(Index k = 0; k < m; k++) {
+        global[k] = Index(by_rank[k] >> bits);
+        local[Index(by_rank[k] & ((Pair(1) << bits) - 1))] = k;
+    }
+    return { std::move(global), std::move(local) };
+}
+
+// translates a rank used by parse_range into the rank in the suffix array of the whole input
+template<typename LCP, std::signed_integral Index>
+Index global_rank(LCP const& lcp, Index const x) {
+    if constexpr(requires { lcp.global_rank(x); }) return lcp.global_rank(x); else return x;
+}
+
+// constructs the predecessor data structure for the marked phrases, passing the maximum key to those that need to know the universe
+template<typename Marked, std::signed_integral Index>
+Marked make_marked(Index const n) {
+    if constexpr(std::is_constructible_v<Marked, Index>) {
+        return Marked(n - 1);
+    } else {
+        return Marked();
+    }
+}
+
+// prepares the given predecessor data structure for an input of length n, clearing it if it has been used before and supports it,
+// which keeps its memory, and constructing it otherwise
+template<typename Marked, std::signed_integral Index>
+Marked& reuse_marked(std::optional<Marked>& marked, Index const n) {
+    if constexpr(!std::is_constructible_v<Marked, Index> && requires(Marked& m) { m.clear(); }) {
+        if(marked) {
+            marked->clear();
+            return *marked;
+        }
+    }
+    marked.reset();
+    if constexpr(std::is_constructible_v<Marked, Index>) marked.emplace(n - 1); else marked.emplace();
+    return *marked;
+}
+
+// inserts the given pairs of ranks of phrase ends and phrase numbers into the given empty predecessor data structure,
+// using a bulk construction if the data structure provides one
+template<typename Marked, std::signed_integral Index>
+void mark(Marked& marked, std::vector<std::pair<Index, Index>>& marks) {
+    std::sort(marks.begin(), marks.end());
+
+    if constexpr(std::is_constructible_v<Marked, std::span<Index const>, std::span<Index const>> && std::is_move_assignable_v<Marked>) {
+        std::vector<Index> keys(marks.size()), values(marks.size());
+        for(size_t j = 0; j < marks.size(); j++) {
+            keys[j] = marks[j].first;
+            values[j] = marks[j].second;
+        }
+        marked = Marked(std::span<Index const>(keys), std::span<Index const>(values));
+    } else {
+        for(auto const& [key, value] : marks) marked.insert(key, value);
+    }
+}
+
+// marks the phrases of the given parsing except for the latest one in the given empty predecessor data structure
+template<typename Marked, std::signed_integral Index, typename Symbol>
+void mark_phrases(Marked& marked, std::vector<Phrase<Index, Symbol>> const& parsing, Index const* isa) {
+    std::vector<std::pair<Index, Index>> marks; // (rank of phrase end, phrase number)
+    marks.reserve(parsing.size());
+    Index end = -1;
+    for(size_t j = 0; j + 1 < parsing.size(); j++) {
+        end += parsing[j].len;
+        marks.push_back({ isa[end], Index(j) });
+    }
+    mark(marked, marks);
+}
+
+// a source phrase found outside of the input, see NoSource
+template<std::signed_integral Index>
+struct ExternalCandidate {
+    Index lnk; // the phrase number, which is negative and relative to the input's first phrase
+    Index len; // the length of the common suffix with the current prefix of the input
+};
+
+// phrases preceding the input, e.g., those of a lzend::Reference (see ReferenceSource), which parse_range considers as sources
+// besides the marked phrases of the input itself; for that, the source follows the prefixes of the input as it is advanced
+// character by character, and it provides its lexicographically nearest phrases with respect to the current prefix
+// their phrase numbers are negative, so the phrases of the input are numbered as if there were none
+struct NoSource {
+    static constexpr bool enabled = false;
+
+    // the number of phrases of the source
+    size_t num_phrases() const { return 0; }
+
+    // appends the next character of the input to the current prefix
+    template<typename Symbol>
+    void advance(Symbol) {}
+
+    // the phrase ending lexicographically smaller or greater than the current prefix with the longest common suffix, if any,
+    // obeying the given limits and reporting queries to the statistics policy; candidates shorter than min_len need not be found
+    template<std::signed_integral Index, typename Stats>
+    ExternalCandidate<Index> smaller(Index, Limits<Index> const&, Stats&) const { return { 0, 0 }; }
+
+    template<std::signed_integral Index, typename Stats>
+    ExternalCandidate<Index> greater(Index, Limits<Index> const&, Stats&) const { return { 0, 0 }; }
+
+    // no phrase beginning before the returned position can copy from the source after the prefix of length i
+    template<std::signed_integral Index>
+    Index horizon(Index const) const { return std::numeric_limits<Index>::max(); }
+};
+
+// computes the LZ-End parsing of s[b..e) and appends it to the given parsing, with links relative to the range's first phrase,
+// using the given empty predecessor data structure for the marked phrases and obeying the given limits
+//
+// the LCP array, which provides range minimum queries (see LCPWithRMQ and CompactLCP), and the permuted ISA are those of the whole input, so the copied text may extend to before b,
+// but only the phrases of the range are marked and can thus be used as sources
+//
+// no phrase can be longer than max_len + 1, where max_len is at least the maximum LCP value, so a phrase can no longer change
+// once the parsing has advanced by more than max_len positions past its beginning; such final phrases are passed to emit
+// and dropped from the parsing, which eventually only contains the phrases that have not been emitted
+// if a checkpoint is given, which requires the range to be the whole input and nothing to be emitted, parsing resumes from its latest snapshot
+// and snapshots are taken after every interval characters
+// given a LocalLCP, isa contains the local ranks of the range's positions, offset such that isa[b] is the first
+// given an enabled source (see NoSource), which requires the range to be the whole input, its phrases are considered as sources as well
+template<std::signed_integral Index, typename LCP, typename Marked, typename Stats, typename Symbol, typename Emit, typename Source = NoSource>
+void parse_range(std::span<Symbol const> const s, Index const b, Index const e, LCP const& lcp, Index const* isa, Marked& marked, Limits<Index> const& limits, std::vector<Phrase<Index, Symbol>>& parsing, Stats& stats,
+                 Emit&& emit, Index const max_len, Checkpoint<Index, Symbol>* checkpoint = nullptr, size_t const interval = 0, Source&& source = Source()) {
+    Index const n = s.size();
+    assert(!checkpoint || (b == 0 && e == n && parsing.empty() && max_len >= n));
+
+    constexpr bool has_source = std::remove_cvref_t<Source>::enabled;
+    assert(!has_source || (b == 0 && e == n && !checkpoint));
+
+    // the number of ranks, which is the input length unless they are local to the range
+    Index const num_ranks = [&]{ if constexpr(requires { lcp.num_ranks(); }) return Index(lcp.num_ranks()); else return n; }();
+
+    // resume from the latest snapshot, if any
+    Index const resume = checkpoint ? checkpoint->load_snapshot(parsing) : 0;
 
-    if(print_progress) std::cout << timestamp() - t0 << " ms" << std::endl;
-    
-    // discard suffix array and reverse text
-    sa.reset();
-    rs = std::string();
-    
     // initialize predecessor/successor
-    ordered::btree::Map<Index, Index> marked;
+    if(resume) mark_phrases(marked, parsing, isa);
     
     // helpers
     struct Candidate { Index lex_pos; Index lnk; Index len; };
-    
+
+    // nb: a candidate beyond the maximum RMQ interval is returned with a common suffix length of zero, so it is not used as a source
     auto lex_smaller_phrase = [&](Index const x){
+        if(x == 0) return Candidate { 0, 0, 0 };
+        stats.on_predecessor_query();
         auto const r = marked.predecessor(x-1);
-        return r.exists
-            ? Candidate { r.key, r.value, lcp[rmq(r.key+1, x)] }
-            : Candidate { 0, 0, 0 };
+        if(!r.exists) return Candidate { 0, 0, 0 };
+        Index const gx = global_rank(lcp, x), gkey = global_rank(lcp, Index(r.key));
+        if(gx - gkey > limits.max_rmq_interval) [[unlikely]] {
+            stats.on_capped_rmq_query();
+            return Candidate { Index(r.key), r.value, 0 };
+        }
+        stats.on_rmq_query(gkey+1, gx);
+        return Candidate { Index(r.key), r.value, lcp.min(r.key+1, x) };
     };
 
     auto lex_greater_phrase = [&](Index const x){
+        if(x == num_ranks-1) return Candidate { 0, 0, 0 };
+        stats.on_successor_query();
         auto const r = marked.successor(x+1);
-        return r.exists
-            ? Candidate { r.key, r.value, lcp[rmq(x+1, r.key)] }
-            : Candidate { 0, 0, 0 };
+        if(!r.exists) return Candidate { 0, 0, 0 };
+        Index const gx = global_rank(lcp, x), gkey = global_rank(lcp, Index(r.key));
+        if(gkey - gx > limits.max_rmq_interval) [[unlikely]] {
+            stats.on_capped_rmq_query();
+            return Candidate { Index(r.key), r.value, 0 };
+        }
+        stats.on_rmq_query(gx+1, gkey);
+        return Candidate { Index(r.key), r.value, lcp.min(x+1, r.key) };
     };
     
     // parse
-    std::cout << "\tparse ...\t\t\t";
-    std::cout.flush();
-    t0 = timestamp();
-    
-    std::vector<Phrase> parsing;
-    parsing.push_back({0, 1, s[0]}); // initial empty phrase
-    Index z = 0; // index of latest phrase (number of phrases would be z+1)
+    size_t const z0 = resume ? 0 : parsing.size();
+    if(!resume) parsing.push_back({0, 1, s[b]}); // initial empty phrase
+    Index z = parsing.size() - z0 - 1; // index of latest phrase (number of phrases would be z+1)
+
+    // the length of the parsed prefix at which to take the next snapshot, and the first phrase changed since the previous snapshot
+    Index const start = resume ? resume : b + 1;
+    size_t next_snapshot = checkpoint ? size_t(start) + std::max(interval, size_t(1)) : size_t(e);
+    Index first_changed = z;
+
+    // the first phrase that has not been emitted and its starting position, as well as the number of phrases dropped from the parsing
+    // nb: the latest emitted phrase is kept, so the previous phrase of the latest one is always available
+    Index front = 0;
+    Index front_start = b;
+    Index dropped = 0;
+    auto phrase = [&](Index const j) -> Phrase<Index, Symbol>& { return parsing[z0 + (j - dropped)]; };
     
-    for(Index i = 1; i < n; i++) {
-        auto const len1 = parsing[z].len;
-        auto const len2 = len1 + (z > 0 ? parsing[z-1].len : 0);
+    for(Index i = start; i < e; i++) {
+        if constexpr(has_source) source.advance(s[i-1]);
+
+        auto const len1 = parsing.back().len;
+        auto const len2 = len1 + (z > 0 ? phrase(z - 1).len : 0);
         
         auto const isa_last = isa[i-1]; // suffix array neighbourhood 
+
+        // the next iteration's queries will likely be answered near its neighbourhood, so prefetch the RMQ data there
+        if(i + 1 < e) lcp.prefetch(isa[i]);
     
-        // find source phrase candidates
-        Index p1 = -1, p2 = -1;
-        auto find_copy_source = [&](std::function<Candidate(Index)> f){
+        // find source phrase candidates, unless the resulting phrases would exceed the maximum phrase length
+        // nb: phrase numbers of a source are negative (see NoSource), so whether a candidate was found is tracked separately
+        Index p1 = 0, p2 = 0;
+        bool has_p1 = false, has_p2 = false;
+        bool const may_merge = i - b > len1 && len2 < limits.max_phrase_len;
+        auto find_copy_source = [&](auto const& f){
             auto c = f(isa_last);
             if(c.len >= len1) {
                 p1 = c.lnk;
-                if(i > len1) {
-                    if(c.lnk == z-1) c = f(c.lex_pos);
-                    if(c.len >= len2) p2 = c.lnk;
+                has_p1 = true;
+                if(may_merge) {
+                    if(c.lnk == z-1) {
+                        if(!limits.requery) [[unlikely]] {
+                            stats.on_skipped_requery();
+                            return;
+                        }
+                        c = f(c.lex_pos);
+                    }
+                    if(c.len >= len2) {
+                        p2 = c.lnk;
+                        has_p2 = true;
+                    }
                 }
             }
         };
-    
-        find_copy_source(lex_smaller_phrase);
-        if(p1 == -1 || p2 == -1) {
-            find_copy_source(lex_greater_phrase);
+
+        if(len1 < limits.max_phrase_len) [[likely]] {
+            if(!may_merge && i - b > len1) stats.on_capped_phrase();
+            find_copy_source(lex_smaller_phrase);
+            if(!has_p1 || !has_p2) {
+                find_copy_source(lex_greater_phrase);
+            }
+            if constexpr(has_source) {
+                // nb: the source's phrases never are the previous phrase, so they are never queried again
+                auto external = [&](ExternalCandidate<Index> const c){ return Candidate { 0, c.lnk, c.len }; };
+                if(!has_p1 || !has_p2) find_copy_source([&](Index){ return external(source.smaller(has_p1 ? len2 : len1, limits, stats)); });
+                if(!has_p1 || !has_p2) find_copy_source([&](Index){ return external(source.greater(has_p1 ? len2 : len1, limits, stats)); });
+            }
+        } else {
+            stats.on_capped_phrase();
         }
 
         // case distinction according to Lemma 1
-        if(p2 != -1) {
+        if(has_p2) {
             // merge last two phrases
+            stats.on_merge();
+            assert(z > front);
             marked.erase(isa[i - 1 - len1]);
             
             parsing.pop_back();
             --z;
             
-            parsing.back() = Phrase { p2, len2 + 1, s[i] };
-        } else if(p1 != -1) {
+            parsing.back() = Phrase<Index, Symbol> { p2, len2 + 1, s[i] };
+            first_changed = std::min(first_changed, z);
+        } else if(has_p1) {
             // extend last phrase
-            parsing.back() = Phrase { p1, len1 + 1, s[i] };
+            stats.on_extend();
+            parsing.back() = Phrase<Index, Symbol> { p1, len1 + 1, s[i] };
+            first_changed = std::min(first_changed, z);
         } else {
             // lazily mark previous phrase
+            stats.on_new_phrase();
             marked.insert(isa_last, z);
 
             // begin new phrase
-            parsing.push_back(Phrase{ 0, 1, s[i] });
+            parsing.push_back(Phrase<Index, Symbol> { 0, 1, s[i] });
             ++z;
+
+            // emit the phrases that have become final
+            // nb: it suffices to check this when a phrase begins, which bounds the number of phrases kept just as well
+            Index const horizon = std::min(i + 1 - max_len, [&]{ if constexpr(has_source) return source.horizon(i); else return i + 1; }());
+            if(front_start < horizon) {
+                while(front < z && front_start < horizon) {
+                    auto const& f = phrase(front);
+                    emit(f);
+                    front_start += f.len;
+                    ++front;
+                }
+
+                // drop emitted phrases once they make up the larger part of the parsing, so dropping takes amortized constant time per phrase
+                if(size_t(front - 1 - dropped) > std::max(parsing.size() - z0, size_t(1) << 12) / 2) {
+                    parsing.erase(parsing.begin() + z0, parsing.begin() + z0 + (front - 1 - dropped));
+                    dropped = front - 1;
+                }
+            }
+        }
+
+        if(checkpoint && size_t(i) + 1 == next_snapshot && next_snapshot < size_t(e)) [[unlikely]] {
+            // nb: a failed snapshot leaves the previous one intact, so parsing simply continues
+            if(!checkpoint->save_snapshot(parsing, i + 1, first_changed)) std::cerr << "warning: failed to write checkpoint snapshot" << std::endl;
+            next_snapshot += std::max(interval, size_t(1));
+            first_changed = z;
+        }
+    }
+
+    // drop the remaining emitted phrases
+    parsing.erase(parsing.begin() + z0, parsing.begin() + z0 + (front - dropped));
+}
+
+// merges the first phrases of each chunk into the last phrase of the previous chunk as long as the result is a valid LZ-End phrase,
+// given the concatenated parsings of the chunks with global links and the number of each chunk's first phrase
+//
+// since the merged phrase ends where the last absorbed phrase ended, links to that phrase are simply redirected to the merged one;
+// the end of any other absorbed phrase disappears, so a phrase is only absorbed if the end of its predecessor is not referred to;
+// merged phrases are no longer than the given maximum phrase length; returns the number of absorbed phrases
+template<std::signed_integral Index, typename LCP, typename Marked, typename Symbol>
+size_t repair_boundaries(std::vector<Phrase<Index, Symbol>>& parsing, std::vector<size_t> const& chunk_first, LCP const& lcp, Index const* isa, Index const n, Index const max_phrase_len) {
+    size_t const z = parsing.size();
+    size_t const num_chunks = chunk_first.size();
+
+    std::vector<Index> ends(z);
+    std::vector<size_t> target(z); // the phrase that each phrase has been merged into, or itself
+    std::vector<Index> refs(z, 0); // the number of links to each phrase
+    for(size_t j = 0, pos = 0; j < z; j++) {
+        pos += parsing[j].len;
+        ends[j] = pos - 1;
+        target[j] = j;
+        if(parsing[j].len > 1) ++refs[parsing[j].lnk];
+    }
+
+    Marked marked = make_marked<Marked>(n);
+    size_t num_marked = 0; // phrases before this one have been considered for marking
+    size_t num_merged = 0;
+    for(size_t c = 1; c < num_chunks; c++) {
+        size_t const first = chunk_first[c];
+        size_t const last = c + 1 < num_chunks ? chunk_first[c + 1] : z;
+
+        // mark the phrases before the last one of the previous chunk, which are final by now
+        size_t const f = target[first - 1];
+        for(; num_marked < f; num_marked++) {
+            if(target[num_marked] == num_marked) marked.insert(isa[ends[num_marked]], Index(num_marked));
+        }
+
+        for(size_t p = first; p < last; p++) {
+            // the end of p's predecessor must not be referred to by any phrase other than p
+            size_t const prev = (p == first) ? f : p - 1;
+            if(refs[prev] - (parsing[p].len > 1 && size_t(parsing[p].lnk) == prev) > 0) break;
+
+            // the merged phrase would copy the text preceding the end of phrase p, i.e., find the marked phrase with the longest common suffix
+            auto const len = parsing[f].len + parsing[p].len;
+            if(len > max_phrase_len) break;
+            auto const x = isa[ends[p] - 1];
+
+            Index lnk = -1, max_lcs = 0;
+            if(x > 0) {
+                auto const r = marked.predecessor(x - 1);
+                if(r.exists) {
+                    auto const lcs = lcp.min(r.key + 1, x);
+                    if(lcs > max_lcs) { max_lcs = lcs; lnk = r.value; }
+                }
+            }
+            if(x < n - 1) {
+                auto const r = marked.successor(x + 1);
+                if(r.exists) {
+                    auto const lcs = lcp.min(x + 1, r.key);
+                    if(lcs > max_lcs) { max_lcs = lcs; lnk = r.value; }
+                }
+            }
+
+            if(max_lcs < len - 1) break;
+
+            // absorb phrase p
+            if(parsing[f].len > 1) --refs[parsing[f].lnk];
+            if(parsing[p].len > 1) --refs[parsing[p].lnk];
+            ++refs[lnk];
+            refs[f] = refs[p];
+            parsing[f] = Phrase<Index, Symbol> { lnk, len, parsing[p].ext };
+            ends[f] = ends[p];
+            target[p] = f;
+            ++num_merged;
+        }
+    }
+
+    // remove the absorbed phrases and renumber links
+    std::vector<Index> renumber(z);
+    size_t k = 0;
+    for(size_t j = 0; j < z; j++) {
+        if(target[j] == j) {
+            renumber[j] = k;
+            parsing[k++] = parsing[j];
+        } else {
+            renumber[j] = renumber[target[j]];
+        }
+    }
+    parsing.resize(k);
+    for(auto& f : parsing) {
+        if(f.len > 1) f.lnk = renumber[f.lnk];
+    }
+    return num_merged;
+}
+
+}
+
+namespace internal {
+
+// computes the LZ-End parsing of a text of bytes or integer symbols using the given workspace, see lzend::parse
+// if an enabled source of phrases preceding the text is given (see NoSource), the text is parsed in a single chunk and without checkpointing,
+// and the links of the emitted phrases count the source's phrases first
+template<std::signed_integral Index, typename RMQ, typename Marked, typename Stats, typename Symbol, typename Sink, typename Source = NoSource>
+size_t parse_text(std::span<Symbol const> const s, Sink&& sink, Options const& options, Stats& stats, Workspace<Index, Marked, Symbol>& ws, Source&& source = Source()) {
+    constexpr bool has_source = std::remove_cvref_t<Source>::enabled;
+    static_assert(std::is_same_v<Index, int32_t> || std::is_same_v<Index, int64_t>, "only 32-bit and 64-bit indices are supported");
+
+    bool const print_progress = options.print_progress;
+    int const threads = num_threads(options);
+
+    if constexpr(!supports_64bit) {
+        if(s.size() > size_t(INT32_MAX)) throw std::length_error("inputs beyond 2 GiB require libsais64");
+    }
+
+    Index const n = s.size();
+    if(print_progress) {
+        std::cout << "LZ-End input: n=" << n << ", threads=" << threads << (options.low_memory ? ", low memory" : "");
+        if(has_source) std::cout << ", source phrases: " << source.num_phrases();
+        std::cout << std::endl;
+    }
+    if(n == 0) return 0;
+
+    // phase timing, reported to the statistics and printed if requested
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point t0;
+    Clock::duration ttotal = {};
+
+    // cache misses are counted only if statistics are collected
+    CacheMissCounter cache_misses(Stats::enabled);
+    uint64_t cache_misses0 = 0;
+
+    auto begin_phase = [&](char const* label){
+        if(print_progress) { std::cout << "\t" << label; std::cout.flush(); }
+        cache_misses0 = cache_misses.read();
+        t0 = Clock::now();
+    };
+    auto end_phase = [&](Phase const phase){
+        auto const t = Clock::now() - t0;
+        ttotal += t;
+        stats.on_phase(phase, t);
+        if(cache_misses.good()) stats.on_cache_misses(phase, cache_misses.read() - cache_misses0);
+        if(print_progress) std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(t).count() << " ms" << std::endl;
+    };
+
+    // if checkpointing, try to map the LCP array and the permuted ISA of a previous run
+    std::unique_ptr<internal::Checkpoint<Index, Symbol>> checkpoint;
+    Index const* lcp_data = nullptr;
+    Index const* isa_data = nullptr;
+    bool resumed = false;
+    if(!options.checkpoint_dir.empty() && !has_source) {
+        begin_phase("load checkpoint ...\t\t");
+
+        checkpoint = std::make_unique<internal::Checkpoint<Index, Symbol>>(options.checkpoint_dir, s);
+        resumed = checkpoint->load_arrays(lcp_data, isa_data);
+
+        end_phase(Phase::checkpoint);
+        if(print_progress && resumed) std::cout << "\tresuming from checkpoint in " << options.checkpoint_dir << std::endl;
+    }
+
+    if(!resumed) {
+        // reverse text, reading the input front to back so memory-mapped inputs are read sequentially
+        // integer texts are mapped to a contiguous alphabet on the way
+        constexpr bool bytes = sizeof(Symbol) == 1;
+        auto const rs = [&](){ if constexpr(bytes) return ws.text.reserve(n); else return ws.int_text.reserve(n); }();
+        Index k = 0; // the alphabet size of an integer text
+        if constexpr(bytes) {
+            for(Index i = 0; i < n; i++) rs[n-1-i] = s[i];
+        } else {
+            k = internal::reverse_text(s, rs);
+        }
+
+        // construct suffix array
+        begin_phase("compute SA ...\t\t\t");
+
+        Index* const sa = ws.sa.reserve(n);
+        if constexpr(!bytes) internal::compute_sa(rs, sa, n, k, threads);
+        else if constexpr(sizeof(Index) == 4) internal::compute_sa(rs, sa, n, threads, ws.sa_ctx);
+        else internal::compute_sa(rs, sa, n, threads);
+
+        end_phase(Phase::sa);
+        
+        // construct PLCP array and the LCP array from it
+        begin_phase("compute LCP ...\t\t\t");
+
+        Index* const plcp = ws.isa.reserve(n);
+        internal::compute_plcp(rs, sa, plcp, n, threads);
+
+        // discard reverse text
+        ws.release(ws.text);
+        ws.release(ws.int_text);
+
+        if(options.low_memory) {
+            // compute the LCP array in place: turn the suffix array into the ISA, then move PLCP[i] to LCP[ISA[i]]
+            internal::invert_permutation(sa, n);
+            internal::apply_permutation(plcp, sa, n);
+            swap(ws.lcp, ws.isa);
+        } else {
+            internal::compute_lcp(plcp, sa, ws.lcp.reserve(n), n, threads);
+        }
+        lcp_data = ws.lcp.get();
+
+        end_phase(Phase::lcp);
+    }
+    
+    // constructs the permuted inverse suffix array and discards the suffix array
+    auto compute_isa = [&](int const threads){
+        if(options.low_memory) {
+            // the suffix array already has been inverted in place, reverse it
+            std::reverse(ws.sa.get(), ws.sa.get() + n);
+            swap(ws.isa, ws.sa);
+        } else {
+            internal::permute_isa(ws.sa.get(), ws.isa.get(), n, threads);
+        }
+        isa_data = ws.isa.get();
+        ws.release(ws.sa);
+    };
+
+    // decide whether to parse using a compact LCP array, which only pays off if most LCP values are small
+    // nb: its queries are somewhat slower, so it is only used if it shrinks the working set of the parsing loop, the LCP array and the RMQ, by at least a quarter
+    bool compact = false;
+    if(options.compact_lcp) {
+        size_t const num_exceptions = CompactLCP<Index>::count_exceptions(lcp_data, n, threads);
+        size_t const full_size = size_t(n) * sizeof(Index) + [&]{ if constexpr(requires { RMQ::size_in_bytes(size_t(n)); }) return RMQ::size_in_bytes(n); else return size_t(0); }();
+        compact = CompactLCP<Index>::size_in_bytes(n, num_exceptions) <= full_size / 4 * 3;
+        if(print_progress && !compact) std::cout << "\tnot using a compact LCP array, because " << num_exceptions << " values are too large" << std::endl;
+    }
+
+    // the RMQ over the LCP array, or the compact LCP array with its own RMQ, which replaces the LCP array for parsing
+    RMQ rmq;
+    CompactLCP<Index> compact_lcp;
+    auto compute_rmq = [&](int const threads){
+        if(compact) compact_lcp = CompactLCP<Index>(lcp_data, n, threads);
+        else rmq = RMQ(lcp_data, n, threads);
+    };
+
+    bool const pipelined = options.pipeline && !resumed;
+    if(pipelined) {
+        // construct RMQ data structure and permuted inverse suffix array concurrently
+        begin_phase("compute RMQ + permuted ISA ...\t");
+
+        int const rmq_threads = std::max(threads / 2, 1);
+        Clock::duration t_rmq;
+        std::thread rmq_thread([&](){
+            auto const t0_rmq = Clock::now();
+            compute_rmq(rmq_threads);
+            t_rmq = Clock::now() - t0_rmq;
+        });
+
+        auto const t0_isa = Clock::now();
+        compute_isa(std::max(threads - rmq_threads, 1));
+        auto const t_isa = Clock::now() - t0_isa;
+        rmq_thread.join();
+
+        // nb: the phases are reported separately, but only the wall time counts towards the total, and cache misses are those of the ISA's thread
+        stats.on_phase(Phase::rmq, t_rmq);
+        stats.on_phase(Phase::isa, t_isa);
+        if(cache_misses.good()) stats.on_cache_misses(Phase::isa, cache_misses.read() - cache_misses0);
+        auto const t = Clock::now() - t0;
+        ttotal += t;
+        if(print_progress) std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(t).count() << " ms" << std::endl;
+    } else {
+        // construct RMQ data structure
+        if(!compact) {
+            begin_phase("compute RMQ ...\t\t\t");
+            compute_rmq(threads);
+            end_phase(Phase::rmq);
+        }
+
+        if(!resumed) {
+            // construct permuted inverse suffix array
+            begin_phase("compute permuted ISA ...\t");
+
+            compute_isa(threads);
+
+            end_phase(Phase::isa);
+        }
+    }
+    
+    if(checkpoint && !resumed) {
+        begin_phase("save checkpoint ...\t\t");
+        if(!checkpoint->save_arrays(lcp_data, isa_data)) std::cerr << "warning: failed to write checkpoint to " << options.checkpoint_dir << std::endl;
+        end_phase(Phase::checkpoint);
+    }
+
+    // the compact LCP array replaces the full one, which is only kept if it is mapped from a checkpoint
+    // nb: unless pipelined, the compact LCP array is constructed only now, after the suffix array has been discarded, so the peak memory does not grow
+    if(compact) {
+        if(!pipelined) {
+            begin_phase("compute compact LCP + RMQ ...\t");
+            compute_rmq(threads);
+            end_phase(Phase::rmq);
         }
+
+        ws.release(ws.lcp);
+        lcp_data = nullptr;
+        if(print_progress) std::cout << "\tcompact LCP: " << compact_lcp.num_exceptions() << " exceptions, " << (compact_lcp.size_in_bytes() >> 20) << " MiB" << std::endl;
     }
+
+    auto& parsing = ws.parsing; // the phrases that have not yet been passed to the sink
+    parsing.clear();
+    size_t z = 0;
+    Index const z_source = source.num_phrases();
+    auto emit = [&](Phrase<Index, Symbol> f){
+        if(f.len > 1) f.lnk += z_source;
+        sink(f);
+        ++z;
+    };
+
+    // parses and repairs the chunk boundaries using the given LCP array with range minimum queries
+    size_t const num_chunks = has_source ? 1 : std::clamp(options.num_chunks > 0 ? options.num_chunks : size_t(threads), size_t(1), size_t(n));
+    internal::Limits<Index> const limits(options, n);
+    auto parse_and_repair = [&](auto const& lcp){
+        begin_phase("parse ...\t\t\t");
+
+        std::vector<size_t> chunk_first; // the number of each chunk's first phrase
+        if(num_chunks == 1) {
+            // snapshots need the whole parsing, so phrases are only emitted early without checkpointing
+            Index max_lcp = n;
+            if(!checkpoint) {
+                if constexpr(std::is_same_v<std::remove_cvref_t<decltype(lcp)>, CompactLCP<Index>>) {
+                    max_lcp = lcp.max();
+                } else {
+                    max_lcp = 0;
+                    #pragma omp parallel for num_threads(threads) if(threads > 1) reduction(max:max_lcp)
+                    for(Index i = 0; i < n; i++) max_lcp = std::max(max_lcp, lcp_data[i]);
+                }
+
+                // nb: phrases are also no longer than the maximum phrase length
+                max_lcp = std::min(max_lcp, limits.max_phrase_len - 1);
+            }
+
+            auto& marked = internal::reuse_marked(ws.marked, n);
+            internal::parse_range<Index>(s, 0, n, lcp, isa_data, marked, limits, parsing, stats, emit, max_lcp, checkpoint.get(), options.checkpoint_interval, std::forward<Source>(source));
+        } else {
+            // parse chunks in parallel, collecting statistics separately
+            std::vector<std::vector<Phrase<Index, Symbol>>> chunk_parsings(num_chunks);
+            std::vector<Stats> chunk_stats(num_chunks);
+            #pragma omp parallel for num_threads(threads) if(threads > 1) schedule(dynamic, 1)
+            for(size_t c = 0; c < num_chunks; c++) {
+                Index const b = size_t(n) * c / num_chunks;
+                Index const e = size_t(n) * (c + 1) / num_chunks;
+                if constexpr(std::is_constructible_v<Marked, Index>) {
+                    // nb: universe-based structures are sized to the chunk by renumbering the ranks of its positions
+                    auto const [global, local] = internal::local_ranks(isa_data, b, e);
+                    internal::LocalLCP<Index, std::remove_cvref_t<decltype(lcp)>> const local_lcp { lcp, global };
+                    Marked marked = internal::make_marked<Marked>(e - b);
+                    internal::parse_range<Index>(s, b, e, local_lcp, local.data() - b, marked, limits, chunk_parsings[c], chunk_stats[c], [](Phrase<Index, Symbol> const&){}, n);
+                } else {
+                    Marked marked = internal::make_marked<Marked>(n);
+                    internal::parse_range<Index>(s, b, e, lcp, isa_data, marked, limits, chunk_parsings[c], chunk_stats[c], [](Phrase<Index, Symbol> const&){}, n);
+                }
+            }
+
+            // concatenate the chunks' parsings, turning links into global phrase numbers
+            chunk_first.resize(num_chunks);
+            for(size_t c = 0; c < num_chunks; c++) {
+                stats.accumulate(chunk_stats[c]);
+                chunk_first[c] = parsing.size();
+                Index const z0 = parsing.size();
+                for(auto f : chunk_parsings[c]) {
+                    if(f.len > 1) f.lnk += z0;
+                    parsing.push_back(f);
+                }
+                chunk_parsings[c] = std::vector<Phrase<Index, Symbol>>();
+            }
+        }
+        end_phase(Phase::parse);
+
+        // merge phrases across chunk boundaries
+        if(chunk_first.size() > 1 && options.repair_boundaries) {
+            begin_phase("repair chunk boundaries ...\t");
+            stats.on_repair(internal::repair_boundaries<Index, std::remove_cvref_t<decltype(lcp)>, Marked>(parsing, chunk_first, lcp, isa_data, n, limits.max_phrase_len));
+            end_phase(Phase::repair);
+        }
+    };
+
+    if(compact) parse_and_repair(compact_lcp);
+    else parse_and_repair(internal::LCPWithRMQ<Index, RMQ> { lcp_data, rmq });
+
+    // emit the remaining phrases
+    for(auto const& f : parsing) emit(f);
+    parsing.clear();
+    if(!ws.retain) parsing.shrink_to_fit();
+
+    // the parse is complete, so the checkpoint is no longer needed
+    if(checkpoint) checkpoint->remove();
+
     if(print_progress) {
-        std::cout << timestamp() - t0 << " ms" << std::endl;
-        std::cout << "\ttotal\t\t\t\t" << timestamp() - ttotal0 << " ms" << std::endl;
+        std::cout << "\ttotal\t\t\t\t" << std::chrono::duration_cast<std::chrono::milliseconds>(ttotal).count() << " ms" << std::endl;
     }
+    return z;
+}
+
+// computes the LZ-End parsing of a text of bytes or integer symbols, releasing all working memory afterwards
+template<std::signed_integral Index, typename RMQ, typename Marked, typename Stats, typename Symbol, typename Sink>
+size_t parse_text(std::span<Symbol const> const s, Sink&& sink, Options const& options, Stats& stats) {
+    Workspace<Index, Marked, Symbol> ws;
+    return parse_text<Index, RMQ, Marked>(s, std::forward<Sink>(sink), options, stats, ws);
+}
+
+}
+
+// computes the LZ-End parsing, passes each phrase to the sink as soon as it is final and returns the number of phrases
+//
+// when parsing in a single chunk without checkpointing, only the phrases that may still change are kept in memory,
+// which are those that begin within the maximum LCP value from the current position; otherwise, all phrases are passed to the sink at the end
+// the index type determines the maximum input length and must be either int32_t or int64_t, where inputs beyond 2 GiB require libsais64
+// the RMQ type can be used to select the RMQ engine, e.g., rmq::RMQStackBitmask to save space
+// the marked type is the predecessor data structure mapping ISA ranks of marked phrase ends to phrase numbers;
+// besides B-trees, universe-based structures like ordered::range_marking::Map or ordered::bit_trie::Map can be used, keyed by the unsigned index type
+// the statistics policy receives per-phase timings and the events of the parsing loop, e.g., lzend::Stats (see stats.hpp)
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>,
+    typename Stats = NoStats,
+    std::invocable<Phrase<Index> const&> Sink>
+size_t parse(std::string_view const s, Sink&& sink, Options const& options, Stats& stats) {
+    return internal::parse_text<Index, RMQ, Marked>(std::span<char const>(s.data(), s.size()), std::forward<Sink>(sink), options, stats);
+}
+
+// computes the LZ-End parsing and passes each phrase to the sink as soon as it is final, without collecting statistics
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>,
+    std::invocable<Phrase<Index> const&> Sink>
+size_t parse(std::string_view const s, Sink&& sink, Options const& options = {}) {
+    NoStats stats;
+    return parse<Index, RMQ, Marked>(s, std::forward<Sink>(sink), options, stats);
+}
+
+// computes the LZ-End parsing and returns it
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>,
+    typename Stats = NoStats>
+std::vector<Phrase<Index>> parse(std::string_view const s, Options const& options, Stats& stats) {
+    std::vector<Phrase<Index>> parsing;
+    parse<Index, RMQ, Marked>(s, [&](Phrase<Index> const& f){ parsing.push_back(f); }, options, stats);
+    return parsing;
+}
+
+// computes the LZ-End parsing and returns it without collecting statistics
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>>
+std::vector<Phrase<Index>> parse(std::string_view const s, Options const& options = {}) {
+    NoStats stats;
+    return parse<Index, RMQ, Marked>(s, options, stats);
+}
+
+// computes the LZ-End parsing of a byte sequence, e.g., a memory-mapped file
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>,
+    typename Stats = NoStats>
+std::vector<Phrase<Index>> parse(std::span<uint8_t const> const s, Options const& options, Stats& stats) {
+    return parse<Index, RMQ, Marked>(std::string_view((char const*)s.data(), s.size()), options, stats);
+}
+
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>>
+std::vector<Phrase<Index>> parse(std::span<uint8_t const> const s, Options const& options = {}) {
+    NoStats stats;
+    return parse<Index, RMQ, Marked>(s, options, stats);
+}
+
+// computes the LZ-End parsing of a sequence of integer symbols, e.g., tokens or k-mers, passes each phrase to the sink as soon as it is final
+// and returns the number of phrases
+//
+// the phrases' extensions are the original symbols, but for suffix sorting, the symbols are mapped to a contiguous alphabet,
+// which requires sorting them if they span a range larger than the input length
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>,
+    typename Stats = NoStats,
+    IntegerSymbol Symbol,
+    std::invocable<Phrase<Index, Symbol> const&> Sink>
+size_t parse(std::span<Symbol const> const s, Sink&& sink, Options const& options, Stats& stats) {
+    return internal::parse_text<Index, RMQ, Marked>(s, std::forward<Sink>(sink), options, stats);
+}
+
+// computes the LZ-End parsing of a sequence of integer symbols and returns it
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>,
+    typename Stats = NoStats,
+    IntegerSymbol Symbol>
+std::vector<Phrase<Index, Symbol>> parse(std::span<Symbol const> const s, Options const& options, Stats& stats) {
+    std::vector<Phrase<Index, Symbol>> parsing;
+    internal::parse_text<Index, RMQ, Marked>(s, [&](Phrase<Index, Symbol> const& f){ parsing.push_back(f); }, options, stats);
     return parsing;
 }
 
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>,
+    IntegerSymbol Symbol>
+std::vector<Phrase<Index, Symbol>> parse(std::span<Symbol const> const s, Options const& options = {}) {
+    NoStats stats;
+    return parse<Index, RMQ, Marked>(s, options, stats);
+}
+
+// a parser that keeps its working memory across inputs, so that parsing many small inputs, e.g., documents,
+// is not dominated by memory allocation and page faults
+//
+// the arrays only ever grow, a predecessor data structure that can be cleared keeps its nodes, and if 32-bit indices are used,
+// libsais keeps its working memory in a context; the memory is released when the parser is destroyed or on request
+// a parser must not be used by multiple threads at the same time, see parse_batch for parsing documents concurrently
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>>
+class Parser {
+private:
+    Options options_;
+    internal::Workspace<Index, Marked> ws_;
+
+public:
+    Parser(Options const& options = {}) : options_(options) {
+        ws_.retain = true;
+        if constexpr(std::is_same_v<Index, int32_t>) {
+#ifdef LIBSAIS_OPENMP
+            int const threads = internal::num_threads(options);
+            ws_.sa_ctx = threads != 1 ? libsais_create_ctx_omp(threads) : libsais_create_ctx();
+#else
+            ws_.sa_ctx = libsais_create_ctx();
+#endif
+        }
+    }
+
+    ~Parser() {
+        if(ws_.sa_ctx) libsais_free_ctx(ws_.sa_ctx);
+    }
+
+    Parser(Parser const&) = delete;
+    Parser& operator=(Parser const&) = delete;
+
+    // computes the LZ-End parsing, passes each phrase to the sink as soon as it is final and returns the number of phrases, see lzend::parse
+    template<typename Stats, std::invocable<Phrase<Index> const&> Sink>
+    size_t parse(std::string_view const s, Sink&& sink, Stats& stats) {
+        return internal::parse_text<Index, RMQ, Marked>(std::span<char const>(s.data(), s.size()), std::forward<Sink>(sink), options_, stats, ws_);
+    }
+
+    template<std::invocable<Phrase<Index> const&> Sink>
+    size_t parse(std::string_view const s, Sink&& sink) {
+        NoStats stats;
+        return parse(s, std::forward<Sink>(sink), stats);
+    }
+
+    // computes the LZ-End parsing and returns it
+    std::vector<Phrase<Index>> parse(std::string_view const s) {
+        std::vector<Phrase<Index>> parsing;
+        parse(s, [&](Phrase<Index> const& f){ parsing.push_back(f); });
+        return parsing;
+    }
+
+    // releases the working memory, except for libsais's context
+    void release() {
+        ws_.release_all();
+    }
+
+    Options const& options() const { return options_; }
+};
+
+// computes the LZ-End parsings of many independent documents concurrently and passes each phrase to the sink along with the number of its document,
+// returning the total number of phrases
+//
+// the documents are distributed dynamically over the given number of threads, each of which parses one document at a time using its own Parser,
+// so the sink is called concurrently for different documents, but in order for each document; checkpointing is not supported
+// the statistics of all documents are accumulated in the given statistics policy
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>,
+    typename Stats = NoStats,
+    std::invocable<size_t, Phrase<Index> const&> Sink>
+size_t parse_batch(std::span<std::string_view const> const docs, Sink&& sink, Options const& options, Stats& stats) {
+    int const threads = internal::num_threads(options);
+
+    // each document is parsed using a single thread
+    Options doc_options = options;
+    doc_options.threads = 1;
+    doc_options.print_progress = false;
+    doc_options.checkpoint_dir.clear();
+
+    std::vector<Stats> thread_stats(std::max(threads, 1));
+    size_t z = 0;
+    #pragma omp parallel num_threads(threads) if(threads > 1) reduction(+:z)
+    {
+#ifdef _OPENMP
+        auto& my_stats = thread_stats[omp_get_thread_num()];
+#else
+        auto& my_stats = thread_stats[0];
+#endif
+        Parser<Index, RMQ, Marked> parser(doc_options);
+        
+        #pragma omp for schedule(dynamic, 1)
+        for(size_t d = 0; d < docs.size(); d++) {
+            z += parser.parse(docs[d], [&](Phrase<Index> const& f){ sink(d, f); }, my_stats);
+        }
+    }
+    for(auto const& st : thread_stats) stats.accumulate(st);
+    return z;
+}
+
+// computes the LZ-End parsings of many independent documents concurrently and returns them
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>,
+    typename Stats = NoStats>
+std::vector<std::vector<Phrase<Index>>> parse_batch(std::span<std::string_view const> const docs, Options const& options, Stats& stats) {
+    std::vector<std::vector<Phrase<Index>>> parsings(docs.size());
+    parse_batch<Index, RMQ, Marked>(docs, [&](size_t const d, Phrase<Index> const& f){ parsings[d].push_back(f); }, options, stats);
+    return parsings;
+}
+
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>>
+std::vector<std::vector<Phrase<Index>>> parse_batch(std::span<std::string_view const> const docs, Options const& options = {}) {
+    NoStats stats;
+    return parse_batch<Index, RMQ, Marked>(docs, options, stats);
+}
+
+// computes an LZ-End parsing of the input stream in independent blocks (windows) of at most the given size
+// and passes each phrase to the sink as soon as it is final, returning the total number of phrases
+//
+// phrases can only refer to phrases within the same block, but their links are global phrase indices, so the result
+// is a valid LZ-End parsing of the whole input that may just contain more phrases than the one computed by parse
+// the working memory is bounded by the window size rather than the input length
+// blocks are parsed using 32-bit indices if they fit, the index type is that of the emitted phrases' links
+// the statistics of all blocks are accumulated in the given statistics policy
+template<std::signed_integral Index = int32_t, typename Sink, typename Stats>
+size_t parse_blockwise(std::istream& in, size_t window, Sink&& sink, Options const& options, Stats& stats) {
+    // turns the block's links into global phrase numbers
+    size_t z = 0;
+    auto emit = [&](auto const& f){
+        sink(Phrase<Index> { Index(f.lnk + z), Index(f.len), f.ext });
+    };
+
+    // without libsais64, windows are limited to what can be parsed using 32-bit indices
+    if constexpr(!supports_64bit) window = std::min(window, size_t(INT32_MAX));
+
+    std::string block;
+    while(in) {
+        block.resize(window);
+        in.read(block.data(), window);
+        block.resize(in.gcount());
+        if(block.empty()) break;
+
+#ifdef LZEND_LIBSAIS64
+        if(block.size() > size_t(INT32_MAX)) {
+            z += parse<int64_t>(block, emit, options, stats);
+            continue;
+        }
+#endif
+        z += parse<int32_t>(block, emit, options, stats);
+    }
+    return z;
+}
+
+template<std::signed_integral Index = int32_t, typename Sink>
+size_t parse_blockwise(std::istream& in, size_t const window, Sink&& sink, Options const& options = {}) {
+    NoStats stats;
+    return parse_blockwise<Index>(in, window, std::forward<Sink>(sink), options, stats);
+}
+
 }
 
 #endif
@@ -0,0 +1,111 @@
+/**
+ * mapped_file.hpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _LZEND_MAPPED_FILE_HPP
+#define _LZEND_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lzend {
+
+// a read-only memory mapping of a file
+class MappedFile {
+private:
+    int fd_;
+    void* data_;
+    size_t size_;
+
+public:
+    MappedFile() : fd_(-1), data_(nullptr), size_(0) {
+    }
+
+    // maps the given file, advising the kernel that it will be read sequentially if requested
+    // if the file cannot be opened or mapped, the result is not good
+    MappedFile(std::string const& path, bool const sequential = true) : MappedFile() {
+        fd_ = open(path.c_str(), O_RDONLY);
+        if(fd_ < 0) return;
+
+        struct stat st;
+        if(fstat(fd_, &st) != 0) { close(); return; }
+        size_ = st.st_size;
+        if(size_ == 0) return; // nb: empty files cannot be mapped, but are perfectly good
+
+        data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        if(data_ == MAP_FAILED) { data_ = nullptr; close(); return; }
+        if(sequential) madvise(data_, size_, MADV_SEQUENTIAL);
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(MappedFile&& other) : fd_(std::exchange(other.fd_, -1)), data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {
+    }
+
+    MappedFile& operator=(MappedFile&& other) {
+        close();
+        fd_ = std::exchange(other.fd_, -1);
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        return *this;
+    }
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    // unmaps and closes the file
+    void close() {
+        if(data_) munmap(data_, size_);
+        if(fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    // tells whether the file has been mapped successfully
+    bool good() const { return fd_ >= 0; }
+
+    size_t size() const { return size_; }
+    char const* data() const { return (char const*)data_; }
+
+    std::string_view view() const { return std::string_view(data(), size_); }
+    std::span<uint8_t const> bytes() const { return std::span<uint8_t const>((uint8_t const*)data_, size_); }
+};
+
+}
+
+#endif
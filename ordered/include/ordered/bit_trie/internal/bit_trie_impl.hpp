@@ -0,0 +1,353 @@
+/**
+ * ordered/bit_trie/internal/bit_trie_impl.hpp
+ * part of pdinklag/ordered
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ORDERED_BIT_TRIE_IMPL_HPP
+#define _ORDERED_BIT_TRIE_IMPL_HPP
+
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "../../query_result.hpp"
+
+namespace ordered::bit_trie::internal {
+
+/**
+ * \brief Placeholder value type for sets
+ */
+struct EmptyValue {};
+
+/**
+ * \brief A 64-ary trie of bit vectors over a fixed universe of keys
+ * 
+ * The lowest level contains one bit for each possible key, and each higher level contains one bit for each 64-bit word of the level below,
+ * which is set iff that word is non-zero. This is the word-level variant of a van Emde Boas tree.
+ * Predecessor and successor queries climb up until they find a set bit in the right direction and then descend,
+ * taking O(log_64 u) time on a universe of size u, where each step is a single word operation.
+ * 
+ * Values are stored in a plain array indexed by key, thus the space consumption is dominated by u values.
+ * 
+ * Attempts to insert, remove or query for keys beyond the initially stated maximum key will result in undefined behaviour.
+ * 
+ * \tparam Key the key type
+ * \tparam Value the value type, which is not stored if it is an empty type
+ */
+template<std::unsigned_integral Key, typename Value>
+class BitTrie {
+private:
+    static constexpr bool has_values_ = !std::is_empty_v<Value>;
+
+    using Pack = uint64_t;
+    static constexpr size_t PACK_BITS = 64;
+    static constexpr size_t PACK_SHIFT = 6;
+
+    static constexpr size_t num_packs(size_t const bits) {
+        return (bits + PACK_BITS - 1) / PACK_BITS;
+    }
+
+    static constexpr uint8_t lowest_set_bit(Pack const x) {
+        return std::countr_zero(x);
+    }
+
+    static constexpr uint8_t highest_set_bit(Pack const x) {
+        return PACK_BITS - 1 - std::countl_zero(x);
+    }
+
+    size_t universe_;
+    std::vector<size_t> level_bits_;
+    std::vector<std::unique_ptr<Pack[]>> levels_;
+    std::unique_ptr<Value[]> values_;
+    size_t size_;
+
+    inline bool get_bit(size_t const level, size_t const i) const {
+        return (levels_[level][i >> PACK_SHIFT] >> (i % PACK_BITS)) & 1;
+    }
+
+    // descends from the given position at the given level to the minimum key below it
+    inline Key descend_min(size_t level, size_t i) const {
+        while(level > 0) {
+            --level;
+            i = (i << PACK_SHIFT) + lowest_set_bit(levels_[level][i]);
+        }
+        return Key(i);
+    }
+
+    // descends from the given position at the given level to the maximum key below it
+    inline Key descend_max(size_t level, size_t i) const {
+        while(level > 0) {
+            --level;
+            i = (i << PACK_SHIFT) + highest_set_bit(levels_[level][i]);
+        }
+        return Key(i);
+    }
+
+    inline Value value_of(Key const key) const {
+        if constexpr(has_values_) return values_[key]; else return Value{};
+    }
+
+public:
+    /**
+     * \brief Construct an empty container
+     * 
+     * \param max_key the maximum possible key to be inserted into the container
+     */
+    BitTrie(Key const max_key) : universe_(size_t(max_key) + 1), size_(0) {
+        size_t bits = universe_;
+        while(true) {
+            level_bits_.push_back(bits);
+            levels_.emplace_back(std::make_unique<Pack[]>(num_packs(bits)));
+            if(bits <= PACK_BITS) break;
+            bits = num_packs(bits);
+        }
+
+        if constexpr(has_values_) {
+            values_ = std::make_unique<Value[]>(universe_);
+        }
+    }
+
+    BitTrie(BitTrie&&) = default;
+    BitTrie& operator=(BitTrie&&) = default;
+    BitTrie(BitTrie const&) = delete;
+    BitTrie& operator=(BitTrie const&) = delete;
+
+    /**
+     * \brief Clears the container
+     */
+    void clear() {
+        for(size_t level = 0; level < levels_.size(); level++) {
+            auto const packs = num_packs(level_bits_[level]);
+            for(size_t i = 0; i < packs; i++) levels_[level][i] = 0;
+        }
+        size_ = 0;
+    }
+
+    /**
+     * \brief Inserts the given key and associated value
+     * 
+     * Inserting a key that is already contained results in undefined behaviour.
+     * 
+     * \param key the key to insert; must be at most the maximum key stated during construction
+     * \param value the value to associate with the key
+     */
+    void insert(Key const key, Value const value) {
+        assert(key < universe_);
+        if constexpr(has_values_) values_[key] = value;
+
+        // set bits bottom-up until we reach a word that was already non-empty
+        size_t i = key;
+        for(size_t level = 0; level < levels_.size(); level++) {
+            Pack& pack = levels_[level][i >> PACK_SHIFT];
+            bool const was_empty = (pack == 0);
+            pack |= Pack(1) << (i % PACK_BITS);
+            if(!was_empty) break;
+            i >>= PACK_SHIFT;
+        }
+        ++size_;
+    }
+
+    /**
+     * \brief Inserts the given key
+     * 
+     * The associated value will is default-constructed.
+     * Inserting a key that is already contained results in undefined behaviour.
+     * 
+     * \param key the key to insert; must be at most the maximum key stated during construction
+     */
+    inline void insert(Key const key) {
+        insert(key, Value{});
+    }
+
+    /**
+     * \brief Removes the given key
+     * 
+     * \param key the key to remove; must be at most the maximum key stated during construction
+     * \return true if the key was contained and has been removed by the operation
+     * \return false if the key was not contained and thus nothing was removed
+     */
+    bool erase(Key const key) {
+        assert(key < universe_);
+        if(!get_bit(0, key)) return false;
+
+        // clear bits bottom-up until a word remains non-empty
+        size_t i = key;
+        for(size_t level = 0; level < levels_.size(); level++) {
+            Pack& pack = levels_[level][i >> PACK_SHIFT];
+            pack &= ~(Pack(1) << (i % PACK_BITS));
+            if(pack != 0) break;
+            i >>= PACK_SHIFT;
+        }
+        --size_;
+        return true;
+    }
+
+    /**
+     * \brief Finds the predecessor of the given key, if any
+     * 
+     * If the key is contained, it will be returned as its own predecessor.
+     * 
+     * \param key the key in question; must be at most the maximum key stated during construction
+     * \return the query result
+     */
+    QueryResult<Key, Value> predecessor(Key const key) const {
+        assert(key < universe_);
+        size_t i = key;
+        for(size_t level = 0; level < levels_.size(); level++) {
+            // look for a set bit at or before i in its word
+            auto const shift = PACK_BITS - 1 - (i % PACK_BITS);
+            Pack const pack = (levels_[level][i >> PACK_SHIFT] << shift) >> shift;
+            if(pack) {
+                auto const x = descend_max(level, ((i >> PACK_SHIFT) << PACK_SHIFT) + highest_set_bit(pack));
+                return { true, x, value_of(x) };
+            }
+
+            // continue with the preceding word one level up
+            if((i >> PACK_SHIFT) == 0) break;
+            i = (i >> PACK_SHIFT) - 1;
+        }
+        return QueryResult<Key, Value>::none();
+    }
+
+    /**
+     * \brief Finds the successor of the given key, if any
+     * 
+     * If the key is contained, it will be returned as its own successor.
+     * 
+     * \param key the key in question; must be at most the maximum key stated during construction
+     * \return the query result
+     */
+    QueryResult<Key, Value> successor(Key const key) const {
+        assert(key < universe_);
+        size_t i = key;
+        for(size_t level = 0; level < levels_.size(); level++) {
+            // look for a set bit at or after i in its word
+            Pack const pack = levels_[level][i >> PACK_SHIFT] & (UINT64_MAX << (i % PACK_BITS));
+            if(pack) {
+                auto const x = descend_min(level, ((i >> PACK_SHIFT) << PACK_SHIFT) + lowest_set_bit(pack));
+                return { true, x, value_of(x) };
+            }
+
+            // continue with the succeeding word one level up
+            i = (i >> PACK_SHIFT) + 1;
+            if(level + 1 < levels_.size() && i >= level_bits_[level + 1]) break;
+        }
+        return QueryResult<Key, Value>::none();
+    }
+
+    /**
+     * \brief Tests whether the given key is contained
+     * 
+     * \param key the key in question; must be at most the maximum key stated during construction
+     * \return true iff the key is contained
+     * \return false otherwise
+     */
+    bool contains(Key const key) const {
+        assert(key < universe_);
+        return get_bit(0, key);
+    }
+
+    /**
+     * \brief Finds the given key
+     * 
+     * \param key the key in question; must be at most the maximum key stated during construction
+     * \return the query result
+     */
+    inline QueryResult<Key, Value> find(Key const key) const {
+        return contains(key) ? QueryResult<Key, Value>{ true, key, value_of(key) } : QueryResult<Key, Value>::none();
+    }
+
+    /**
+     * \brief Reports the minimum key contained
+     * 
+     * Querying this on an empty container results in undefined behaviour
+     * 
+     * \return the minimum key contained
+     */
+    inline Key min_key() const {
+        return descend_min(levels_.size() - 1, lowest_set_bit(levels_.back()[0]));
+    }
+
+    /**
+     * \brief Reports the maximum key contained
+     * 
+     * Querying this on an empty container results in undefined behaviour
+     * 
+     * \return the maximum key contained
+     */
+    inline Key max_key() const {
+        return descend_max(levels_.size() - 1, highest_set_bit(levels_.back()[0]));
+    }
+
+    /**
+     * \brief Reports the minimum key contained and the associated value, if any
+     * 
+     * \return the minimum contained
+     */
+    inline QueryResult<Key, Value> min() const {
+        if(size() == 0) [[unlikely]] return QueryResult<Key, Value>::none();
+        auto const x = min_key();
+        return { true, x, value_of(x) };
+    }
+
+    /**
+     * \brief Reports the minimum key contained and the associated value, if any
+     *
+     * \return the maximum contained
+     */
+    inline QueryResult<Key, Value> max() const {
+        if(size() == 0) [[unlikely]] return QueryResult<Key, Value>::none();
+        auto const x = max_key();
+        return { true, x, value_of(x) };
+    }
+
+    /**
+     * \brief Reports the number of keys contained
+     * 
+     * \return the number of keys contained 
+     */
+    inline size_t size() const {
+        return size_;
+    }
+
+    /**
+     * \brief Reports whether the container is empty
+     * 
+     * \return true iff the container's size is zero
+     * \return false iff there are any keys contained
+     */
+    inline bool empty() const {
+        return size_ == 0;
+    }
+};
+
+}
+
+#endif
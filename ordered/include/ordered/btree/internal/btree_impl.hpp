@@ -28,12 +28,18 @@
 #ifndef _ORDERED_BTREE_INTERNAL_IMPL_HPP
 #define _ORDERED_BTREE_INTERNAL_IMPL_HPP
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <iterator>
+#include <new>
+#include <span>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "concepts.hpp"
+#include "node_allocator.hpp"
 #include "../../query_result.hpp"
 
 namespace ordered::btree::internal {
@@ -41,9 +47,19 @@ namespace ordered::btree::internal {
 /**
  * \brief A B-tree
  * 
+ * By default, the child pointers of an inner node are stored in a separately allocated array.
+ * Storing them inline saves one indirection - and typically one cache miss - per level during a search,
+ * at the cost of reserving space for them in every leaf.
+ * 
+ * Nodes - and separately stored child pointer arrays - are obtained from the given allocator.
+ * If the allocator releases all nodes at once when it is destroyed, like \ref PoolAllocator does,
+ * destroying the B-tree does not need to visit the nodes.
+ * 
  * \tparam NodeImpl the node implementation
+ * \tparam inline_children_ whether to store the child pointers inline in each node
+ * \tparam Allocator the node allocator template, see \ref HeapAllocator and \ref PoolAllocator
  */
-template<BTreeNode NodeImpl>
+template<BTreeNode NodeImpl, bool inline_children_ = false, template<typename> typename Allocator = HeapAllocator>
 class BTree {
 private:
     using Key = typename NodeImpl::Key;
@@ -60,17 +76,24 @@ private:
     static constexpr size_t split_right_ = node_capacity / 2;
     static constexpr size_t split_mid_ = split_right_ - 1;
     static constexpr size_t deletion_threshold_ = degree_ / 2;
+    static constexpr size_t min_keys_ = std::max(deletion_threshold_ - 1, size_t(1)); // the minimum number of keys in a non-root node
 
-    class Node {
+    // nb: the node is aligned like its implementation, which comes first, so that implementations can align their keys to cache lines
+    class alignas(alignof(NodeImpl)) Node {
     private:
         friend class BTree;
     
+        using Children = std::conditional_t<inline_children_, Node*[degree_], Node**>;
+
         NodeImpl impl_;
         ChildCount num_children_;
-        Node** children_;
+        Children children_;
     
     public:
-        inline bool is_leaf() const { return children_ == nullptr; }
+        inline bool is_leaf() const {
+            if constexpr(inline_children_) return num_children_ == 0;
+            else return children_ == nullptr;
+        }
         inline size_t size() const { return impl_.size(); }
         ChildCount num_children() const { return num_children_; }
         Node const* child(size_t const i) { return children_[i]; }
@@ -79,31 +102,27 @@ private:
         inline bool is_empty() const { return size() == 0; }
         inline bool is_full() const { return size() == node_capacity; }
 
-        Node() : children_(nullptr), num_children_(0) {
+        Node() : num_children_(0) {
+            if constexpr(!inline_children_) children_ = nullptr;
         }
         
-        ~Node() {
-            for(size_t i = 0; i < num_children_; i++) {
-                delete children_[i];
-            }
-            if(children_) delete[] children_;
-        }
-
         Node(Node const&) = default;
         Node(Node&&) = default;
         Node& operator=(Node const&) = default;
         Node& operator=(Node&&) = default;
 
-        inline void allocate_children() {
-            if(children_ == nullptr) {
-                children_ = new Node*[degree_];
+        inline void allocate_children(BTree& tree) {
+            if constexpr(!inline_children_) {
+                if(children_ == nullptr) {
+                    children_ = tree.children_alloc_.allocate()->children;
+                }
             }
         }
 
-        void insert_child(size_t const i, Node* node) {
+        void insert_child(BTree& tree, size_t const i, Node* node) {
             assert(i <= num_children_);
             assert(num_children_ < degree_);
-            allocate_children();
+            allocate_children(tree);
             
             // insert
             for(size_t j = num_children_; j > i; j--) {
@@ -113,7 +132,7 @@ private:
             ++num_children_;
         }
         
-        void erase_child(size_t const i) {
+        void erase_child(BTree& tree, size_t const i) {
             assert(num_children_ > 0);
             assert(i <= num_children_);
 
@@ -123,24 +142,26 @@ private:
             children_[num_children_-1] = nullptr;
             --num_children_;
             
-            if(num_children_ == 0) {
-                delete[] children_;
-                children_ = nullptr;
+            if constexpr(!inline_children_) {
+                if(num_children_ == 0) {
+                    tree.free_children(children_);
+                    children_ = nullptr;
+                }
             }
         }
 
-        void split_child(const size_t i) {
+        void split_child(BTree& tree, const size_t i) {
             assert(!is_full());
             
             Node* y = children_[i];
             assert(y->is_full());
 
             // allocate new node
-            Node* z = new Node();
+            Node* z = tree.new_node();
 
             // get the middle value
             Key const m = y->impl_[split_mid_];
-            Value value_m;
+            Value value_m = Value();
 
             // move the keys larger than middle from y to z and remove the middle
             {
@@ -157,7 +178,7 @@ private:
 
             // move the m_children right of middle from y to z
             if(!y->is_leaf()) {
-                z->allocate_children();
+                z->allocate_children(tree);
                 for(size_t j = split_right_; j <= node_capacity; j++) {
                     z->children_[z->num_children_++] = y->children_[j];
                 }
@@ -166,7 +187,7 @@ private:
 
             // insert middle into this and add z as child i+1
             impl_.insert(m, value_m);
-            insert_child(i + 1, z);
+            insert_child(tree, i + 1, z);
 
             // some assertions
             assert(children_[i] == y);
@@ -177,7 +198,7 @@ private:
             if(!y->is_leaf()) assert(y->num_children_ == split_mid_ + 1);
         }
         
-        void insert(Key const key, Value const value) {
+        void insert(BTree& tree, Key const key, Value const value) {
             assert(!is_full());
             
             if(is_leaf()) {
@@ -190,18 +211,18 @@ private:
                 
                 if(children_[i]->is_full()) {
                     // it's full, split it up first
-                    split_child(i);
+                    split_child(tree, i);
 
                     // we may have to increase the index of the child to descend into
                     if(key > impl_[i]) ++i;
                 }
 
                 // descend into non-full child
-                children_[i]->insert(key, value);
+                children_[i]->insert(tree, key, value);
             }
         }
 
-        bool erase(Key const key) {
+        bool erase(BTree& tree, Key const key) {
             assert(!is_empty());
 
             if(is_leaf()) {
@@ -235,7 +256,7 @@ private:
                         impl_.insert(key_pred, value_pred);
 
                         // recursively delete key_pred from y
-                        y->erase(key_pred);
+                        y->erase(tree, key_pred);
                     } else if(zsize >= deletion_threshold_) {
                         // find successor of key in z's subtree - i.e., its minimum
                         Node* c = z;
@@ -250,7 +271,7 @@ private:
                         impl_.insert(key_succ, value_succ);
 
                         // recursively delete key_succ from z
-                        z->erase(key_succ);
+                        z->erase(tree, key_succ);
                     } else {
                         // assert balance
                         assert(ysize == deletion_threshold_ - 1);
@@ -282,11 +303,11 @@ private:
                         }
 
                         // delete z
-                        erase_child(i);
-                        delete z;
+                        erase_child(tree, i);
+                        tree.free_node(z);
 
                         // recursively delete key from y
-                        y->erase(key);
+                        y->erase(tree, key);
                     }
                     return true;
                 } else {
@@ -324,8 +345,8 @@ private:
                             // move rightmost child of left sibling to c
                             if(!left->is_leaf()) {
                                 Node* lrightmost = left->children_[left->num_children_-1];
-                                left->erase_child(left->num_children_-1);
-                                c->insert_child(0, lrightmost);
+                                left->erase_child(tree, left->num_children_-1);
+                                c->insert_child(tree, 0, lrightmost);
                             }
                         } else if(right && right->size() >= deletion_threshold_) {
                             // there is a right child, so there must be a splitter
@@ -350,8 +371,8 @@ private:
                             // move leftmost child of right sibling to c
                             if(!right->is_leaf()) {
                                 Node* rleftmost = right->children_[0];
-                                right->erase_child(0);
-                                c->insert_child(c->num_children_, rleftmost);
+                                right->erase_child(tree, 0);
+                                c->insert_child(tree, c->num_children_, rleftmost);
                             }
                         } else {
                             // this node is not a leaf and is not empty, so there must be at least one sibling to the child
@@ -389,8 +410,8 @@ private:
                                 }
                                 
                                 // delete right sibling
-                                erase_child(i+1);
-                                delete right;
+                                erase_child(tree, i+1);
+                                tree.free_node(right);
                             } else {
                                 // merge child with left sibling
                                 Key const splitter = impl_[i-1];
@@ -425,23 +446,178 @@ private:
                                 }
                                 
                                 // delete left sibling
-                                erase_child(i-1);
-                                delete left;
+                                erase_child(tree, i-1);
+                                tree.free_node(left);
                             }
                         }
                     }
                     
                     // remove from subtree
-                    return c->erase(key);
+                    return c->erase(tree, key);
                 }
             }
         }
     } __attribute__((__packed__));
 
 private:
+    // storage for separately stored child pointers
+    struct ChildArray {
+        Node* children[degree_];
+    };
+
+    [[no_unique_address]] Allocator<Node> node_alloc_;
+    [[no_unique_address]] Allocator<ChildArray> children_alloc_;
     size_t size_;
     Node* root_;
 
+    static constexpr bool bulk_release_ = Allocator<Node>::bulk_release && Allocator<ChildArray>::bulk_release && std::is_trivially_destructible_v<NodeImpl>;
+
+    inline Node* new_node() {
+        return new(node_alloc_.allocate()) Node();
+    }
+
+    inline void free_children(Node** children) {
+        // nb: the child pointers are the only member of ChildArray
+        children_alloc_.deallocate(reinterpret_cast<ChildArray*>(children));
+    }
+
+    // frees the given node, but not its children
+    inline void free_node(Node* node) {
+        if constexpr(!inline_children_) {
+            if(node->children_) free_children(node->children_);
+        }
+        node->~Node();
+        node_alloc_.deallocate(node);
+    }
+
+    // frees the given node and its entire subtree
+    void free_subtree(Node* node) {
+        for(size_t i = 0; i < node->num_children_; i++) {
+            free_subtree(node->children_[i]);
+        }
+        free_node(node);
+    }
+
+    // frees all nodes, unless the allocators release them in bulk anyway
+    inline void free_all() {
+        if constexpr(!bulk_release_) {
+            if(root_) free_subtree(root_);
+        }
+        root_ = nullptr;
+    }
+
+    // frees all nodes and resets the allocators if they release in bulk
+    inline void reset() {
+        free_all();
+        if constexpr(bulk_release_) {
+            node_alloc_.release();
+            children_alloc_.release();
+        }
+    }
+
+    // frees all nodes, but keeps the allocators' memory for new nodes if they release in bulk
+    inline void recycle() {
+        if constexpr(bulk_release_) {
+            root_ = nullptr;
+            node_alloc_.recycle();
+            children_alloc_.recycle();
+        } else {
+            free_all();
+        }
+    }
+
+    // computes the number of nodes to distribute n keys over, including one separator key between each two consecutive nodes,
+    // such that each node receives about target keys, but at least the minimum number of keys unless there is only one node
+    static size_t num_nodes(size_t const n, size_t const target) {
+        size_t const m = (n + 1 + target) / (target + 1);
+        return std::max(std::min(m, (n + 1) / (min_keys_ + 1)), size_t(1));
+    }
+
+    // builds the tree bottom-up from the given strictly increasing keys, filling each node with about target keys
+    template<typename ValueAt>
+    void build(std::span<Key const> keys, ValueAt value_at, double const fill) {
+        assert(fill > 0.0 && fill <= 1.0);
+        assert(std::adjacent_find(keys.begin(), keys.end(), [](Key const& a, Key const& b){ return !(a < b); }) == keys.end());
+        size_t const target = std::clamp(size_t(fill * node_capacity + 0.5), min_keys_, node_capacity);
+
+        // the nodes of the current level and the positions of the keys separating them
+        std::vector<Node*> nodes;
+        std::vector<size_t> seps;
+
+        // build the leaves
+        {
+            size_t const n = keys.size();
+            size_t const m = num_nodes(n, target);
+            size_t const base = (n - (m - 1)) / m;
+            size_t const extra = (n - (m - 1)) % m;
+
+            nodes.reserve(m);
+            seps.reserve(m - 1);
+            size_t k = 0;
+            for(size_t j = 0; j < m; j++) {
+                Node* leaf = new_node();
+                for(size_t c = base + (j < extra); c > 0; c--, k++) leaf->impl_.insert(keys[k], value_at(k));
+                nodes.push_back(leaf);
+                if(j + 1 < m) seps.push_back(k++);
+            }
+            assert(k == n);
+        }
+
+        // build the inner levels, distributing the separators of each level over the nodes of the next
+        while(nodes.size() > 1) {
+            size_t const n = seps.size();
+            size_t const m = num_nodes(n, target);
+            size_t const base = (n - (m - 1)) / m;
+            size_t const extra = (n - (m - 1)) % m;
+
+            std::vector<Node*> parents;
+            std::vector<size_t> parent_seps;
+            parents.reserve(m);
+            parent_seps.reserve(m - 1);
+            size_t k = 0, c = 0;
+            for(size_t j = 0; j < m; j++) {
+                Node* node = new_node();
+                node->allocate_children(*this);
+                for(size_t x = base + (j < extra); x > 0; x--, k++) {
+                    node->impl_.insert(keys[seps[k]], value_at(seps[k]));
+                    node->children_[node->num_children_++] = nodes[c++];
+                }
+                node->children_[node->num_children_++] = nodes[c++];
+                parents.push_back(node);
+                if(j + 1 < m) parent_seps.push_back(seps[k++]);
+            }
+            assert(k == n);
+            assert(c == nodes.size());
+
+            nodes = std::move(parents);
+            seps = std::move(parent_seps);
+        }
+
+        root_ = nodes[0];
+        size_ = keys.size();
+    }
+
+    // calls f for each key and its associated value in the subtree of the given node in ascending order
+    template<typename F>
+    void for_each(Node const* node, F& f) const {
+        for(size_t i = 0; i < node->size(); i++) {
+            if(!node->is_leaf()) for_each(node->children_[i], f);
+            f(node->impl_[i], node->impl_.value(i));
+        }
+        if(!node->is_leaf()) for_each(node->children_[node->num_children_ - 1], f);
+    }
+
+    // collects the keys in [lo, hi] contained in the subtree of the given node in ascending order, returns false as soon as there are more than limit
+    bool collect_range(Node const* node, Key const lo, Key const hi, std::vector<Key>& out, size_t const limit) const {
+        auto const r = node->impl_.successor(lo);
+        for(size_t i = r.exists ? r.pos : node->size();; i++) {
+            if(!node->is_leaf() && !collect_range(node->children_[i], lo, hi, out, limit)) return false;
+            if(i >= node->size() || node->impl_[i] > hi) return true;
+            if(out.size() == limit) return false;
+            out.push_back(node->impl_[i]);
+        }
+    }
+
     Node const& leftmost_leaf() const {
         Node* node = root_;
         while(!node->is_leaf()) {
@@ -462,27 +638,57 @@ public:
     /**
      * \brief Constructs an empty container
      */
-    inline BTree() : size_(0), root_(new Node()) {
+    inline BTree() : size_(0), root_(nullptr) {
+        root_ = new_node();
     }
 
-    inline BTree(BTree&& other) {
-        *this = other;
+    inline BTree(BTree&& other) : size_(0), root_(nullptr) {
+        *this = std::move(other);
     }
 
     inline BTree& operator=(BTree&& other) {
+        free_all();
+        node_alloc_ = std::move(other.node_alloc_);
+        children_alloc_ = std::move(other.children_alloc_);
         size_ = other.size_;
         root_ = other.root_;
         other.root_ = nullptr;
+        other.size_ = 0;
         return *this;
     }
 
+    /**
+     * \brief Constructs a container from the given keys and associated values in linear time
+     * 
+     * The nodes are built bottom-up, each receiving about the given fraction of the node capacity.
+     * A smaller fill factor leaves room for subsequent insertions before nodes need to be split.
+     * 
+     * \param keys the keys, which must be strictly increasing
+     * \param values the values associated with the keys
+     * \param fill the fill factor for the nodes, in (0, 1]
+     */
+    inline BTree(std::span<Key const> keys, std::span<Value const> values, double const fill = 1.0) : size_(0), root_(nullptr) {
+        assert(keys.size() == values.size());
+        build(keys, [&](size_t const i){ return values[i]; }, fill);
+    }
+
+    /**
+     * \brief Constructs a container from the given keys in linear time
+     * 
+     * The associated values are default-constructed.
+     * 
+     * \param keys the keys, which must be strictly increasing
+     * \param fill the fill factor for the nodes, in (0, 1]
+     */
+    explicit inline BTree(std::span<Key const> keys, double const fill = 1.0) : size_(0), root_(nullptr) {
+        build(keys, [](size_t){ return Value{}; }, fill);
+    }
+
     BTree(BTree const&) = delete;
     BTree& operator=(BTree const&) = delete;
 
     inline ~BTree() {
-        if(root_) {
-            delete root_;
-        }
+        free_all();
     }
 
     /**
@@ -497,8 +703,8 @@ public:
         Node* node = root_;
         
         bool exists = false;
-        Key key;
-        Value value;
+        Key key = Key();
+        Value value = Value();
         
         auto r = node->impl_.predecessor(x);
         while(!node->is_leaf()) {
@@ -537,8 +743,8 @@ public:
         Node* node = root_;
         
         bool exists = false;
-        Key key;
-        Value value;
+        Key key = Key();
+        Value value = Value();
         
         auto r = node->impl_.successor(x);
         while(!node->is_leaf()) {
@@ -648,13 +854,13 @@ public:
     inline void insert(Key const key, Value const value) {
         if(root_->is_full()) {
             // root is full, split it up
-            Node* new_root = new Node();
-            new_root->insert_child(0, root_);
+            Node* new_root = new_node();
+            new_root->insert_child(*this, 0, root_);
 
             root_ = new_root;
-            root_->split_child(0);
+            root_->split_child(*this, 0);
         }
-        root_->insert(key, value);
+        root_->insert(*this, key, value);
         ++size_;
     }
 
@@ -680,7 +886,7 @@ public:
     inline bool erase(Key const key) {
         assert(size_ > 0);
         
-        bool const result = root_->erase(key);
+        bool const result = root_->erase(*this, key);
         
         if(result) {
             --size_;
@@ -692,18 +898,60 @@ public:
             // root is now empty but it still has a child, make that new root
             Node* new_root = root_->children_[0];
             root_->num_children_ = 0;
-            delete root_;
+            free_node(root_);
             root_ = new_root;
         }
         return result;
     }
 
+    /**
+     * \brief Removes all keys in the given range
+     * 
+     * If only few keys are affected, they are removed one by one.
+     * Otherwise, the container is rebuilt from the remaining keys in linear time.
+     * 
+     * \param lo the lower bound of the range (inclusive)
+     * \param hi the upper bound of the range (inclusive)
+     * \param fill the fill factor for the nodes in case the container is rebuilt, in (0, 1]
+     * \return the number of keys removed
+     */
+    inline size_t erase_range(Key const lo, Key const hi, double const fill = 1.0) {
+        if(size_ == 0 || hi < lo) return 0;
+
+        // try to collect the affected keys, giving up once removing them one by one becomes more expensive than rebuilding
+        std::vector<Key> range;
+        if(collect_range(root_, lo, hi, range, size_ / 16)) {
+            for(Key const& key : range) erase(key);
+            return range.size();
+        }
+
+        // rebuild from the remaining keys
+        std::vector<Key> keys;
+        std::vector<Value> values;
+        keys.reserve(size_ - range.size());
+        values.reserve(size_ - range.size());
+        auto keep = [&](Key const& key, Value const& value){
+            if(key < lo || hi < key) {
+                keys.push_back(key);
+                values.push_back(value);
+            }
+        };
+        for_each(root_, keep);
+
+        size_t const erased = size_ - keys.size();
+        reset();
+        build(keys, [&](size_t const i){ return values[i]; }, fill);
+        return erased;
+    }
+
     /**
      * \brief Clears the container
+     * 
+     * If the allocator releases all nodes at once, its memory is kept for subsequent insertions.
      */
     inline void clear() {
-        delete root_;
-        root_ = new Node();
+        recycle();
+        root_ = new_node();
         size_ = 0;
     }
 
@@ -0,0 +1,198 @@
+/**
+ * ordered/btree/internal/node_allocator.hpp
+ * part of pdinklag/ordered
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ORDERED_BTREE_INTERNAL_NODE_ALLOCATOR_HPP
+#define _ORDERED_BTREE_INTERNAL_NODE_ALLOCATOR_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace ordered::btree::internal {
+
+/**
+ * \brief Node allocator that allocates each node individually on the heap
+ * 
+ * \tparam T the node type
+ */
+template<typename T>
+class HeapAllocator {
+public:
+    /**
+     * \brief Whether releasing the allocator releases all nodes allocated from it
+     */
+    static constexpr bool bulk_release = false;
+
+    HeapAllocator() {
+    }
+
+    HeapAllocator(HeapAllocator&&) = default;
+    HeapAllocator& operator=(HeapAllocator&&) = default;
+
+    /**
+     * \brief Allocates uninitialized storage for a node
+     * 
+     * \return the allocated storage
+     */
+    inline T* allocate() {
+        return static_cast<T*>(::operator new(sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    /**
+     * \brief Releases the storage of a node
+     * 
+     * \param p the storage to release
+     */
+    inline void deallocate(T* p) {
+        ::operator delete(p, std::align_val_t(alignof(T)));
+    }
+};
+
+/**
+ * \brief Node allocator that allocates nodes from contiguous slabs
+ * 
+ * Released nodes are kept in a free list and recycled by subsequent allocations.
+ * The slabs grow geometrically up to the given maximum size, so small containers stay small,
+ * and are only returned to the system when the allocator is destroyed,
+ * which releases all nodes at once in time linear in the number of slabs.
+ * Alternatively, all nodes can be recycled at once while keeping the slabs for subsequent allocations.
+ * 
+ * \tparam T the node type
+ * \tparam max_slab_size_ the maximum number of nodes per slab
+ */
+template<typename T, size_t max_slab_size_ = 1024>
+class PoolAllocator {
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) std::byte storage[sizeof(T)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> slabs_;
+    size_t num_used_slabs_;
+    Slot* free_;
+    Slot* cur_;
+    Slot* end_;
+
+    static constexpr size_t slab_size(size_t const i) {
+        return i < 63 ? std::min(size_t(1) << i, max_slab_size_) : max_slab_size_;
+    }
+
+    // continues allocating from the next slab, reusing a recycled one if available
+    void grow() {
+        size_t const size = slab_size(num_used_slabs_);
+        if(num_used_slabs_ == slabs_.size()) slabs_.emplace_back(new Slot[size]);
+        cur_ = slabs_[num_used_slabs_++].get();
+        end_ = cur_ + size;
+    }
+
+public:
+    /**
+     * \brief Whether releasing the allocator releases all nodes allocated from it
+     */
+    static constexpr bool bulk_release = true;
+
+    PoolAllocator() : num_used_slabs_(0), free_(nullptr), cur_(nullptr), end_(nullptr) {
+    }
+
+    PoolAllocator(PoolAllocator&& other) {
+        *this = std::move(other);
+    }
+
+    PoolAllocator& operator=(PoolAllocator&& other) {
+        slabs_ = std::move(other.slabs_);
+        num_used_slabs_ = other.num_used_slabs_;
+        free_ = other.free_;
+        cur_ = other.cur_;
+        end_ = other.end_;
+        other.release();
+        return *this;
+    }
+
+    PoolAllocator(PoolAllocator const&) = delete;
+    PoolAllocator& operator=(PoolAllocator const&) = delete;
+
+    /**
+     * \brief Allocates uninitialized storage for a node
+     * 
+     * \return the allocated storage
+     */
+    inline T* allocate() {
+        Slot* slot;
+        if(free_) {
+            slot = free_;
+            free_ = slot->next;
+        } else {
+            if(cur_ == end_) [[unlikely]] grow();
+            slot = cur_++;
+        }
+        return reinterpret_cast<T*>(slot->storage);
+    }
+
+    /**
+     * \brief Puts the storage of a node into the free list for recycling
+     * 
+     * \param p the storage to release
+     */
+    inline void deallocate(T* p) {
+        Slot* slot = reinterpret_cast<Slot*>(p);
+        slot->next = free_;
+        free_ = slot;
+    }
+
+    /**
+     * \brief Releases all slabs, invalidating all nodes allocated from this allocator
+     */
+    inline void release() {
+        slabs_.clear();
+        num_used_slabs_ = 0;
+        free_ = cur_ = end_ = nullptr;
+    }
+
+    /**
+     * \brief Makes the storage of all nodes available for subsequent allocations, invalidating all nodes allocated from this allocator
+     * 
+     * The slabs are kept, so allocating the same number of nodes again does not allocate any memory.
+     */
+    inline void recycle() {
+        num_used_slabs_ = 0;
+        free_ = cur_ = end_ = nullptr;
+    }
+
+    /**
+     * \brief Reports the number of slabs currently allocated
+     * 
+     * \return the number of slabs
+     */
+    inline size_t num_slabs() const { return slabs_.size(); }
+};
+
+}
+
+#endif
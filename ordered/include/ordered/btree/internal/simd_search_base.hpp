@@ -0,0 +1,242 @@
+/**
+ * ordered/btree/internal/simd_search_base.hpp
+ * part of pdinklag/ordered
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ORDERED_BTREE_INTERNAL_SIMD_SEARCH_BASE_HPP
+#define _ORDERED_BTREE_INTERNAL_SIMD_SEARCH_BASE_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "../../internal/local_query_result.hpp"
+
+namespace ordered::btree::internal {
+
+// the size of a cache line, which is also the unit of the SIMD rank search
+constexpr size_t cache_line_size = 64;
+
+// tells whether keys of the given type can be compared using the SIMD instruction set selected at compile time
+template<typename Key>
+constexpr bool simd_rank_supported =
+#if defined(__AVX512F__) || defined(__AVX2__) || (defined(__ARM_NEON) && defined(__aarch64__))
+    std::integral<Key> && (sizeof(Key) == 4 || sizeof(Key) == 8);
+#else
+    false;
+#endif
+
+// counts the keys in the given cache line that are less than (strict) or less than or equal to (non-strict) x
+template<bool strict, typename Key>
+inline size_t simd_rank_line(Key const* line, Key const x) {
+    static_assert(simd_rank_supported<Key>);
+    constexpr bool is_signed = std::is_signed_v<Key>;
+    constexpr bool is_64 = sizeof(Key) == 8;
+#if defined(__AVX512F__)
+    __m512i const k = _mm512_load_si512(line);
+    if constexpr(is_64) {
+        __m512i const v = _mm512_set1_epi64(int64_t(x));
+        if constexpr(is_signed) return std::popcount(unsigned(strict ? _mm512_cmplt_epi64_mask(k, v) : _mm512_cmple_epi64_mask(k, v)));
+        else                    return std::popcount(unsigned(strict ? _mm512_cmplt_epu64_mask(k, v) : _mm512_cmple_epu64_mask(k, v)));
+    } else {
+        __m512i const v = _mm512_set1_epi32(int32_t(x));
+        if constexpr(is_signed) return std::popcount(unsigned(strict ? _mm512_cmplt_epi32_mask(k, v) : _mm512_cmple_epi32_mask(k, v)));
+        else                    return std::popcount(unsigned(strict ? _mm512_cmplt_epu32_mask(k, v) : _mm512_cmple_epu32_mask(k, v)));
+    }
+#elif defined(__AVX2__)
+    // AVX2 only provides signed greater-than comparisons, so unsigned keys are shifted into the signed range
+    // keys less than x are those where x > k, keys less than or equal to x are those where not k > x
+    size_t r = 0;
+    for(size_t half = 0; half < 2; half++) {
+        __m256i k = _mm256_load_si256((__m256i const*)line + half);
+        if constexpr(is_64) {
+            __m256i v = _mm256_set1_epi64x(int64_t(x));
+            if constexpr(!is_signed) {
+                __m256i const bias = _mm256_set1_epi64x(INT64_MIN);
+                k = _mm256_xor_si256(k, bias);
+                v = _mm256_xor_si256(v, bias);
+            }
+            if constexpr(strict) r += std::popcount(unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, k)))));
+            else                 r += 4 - std::popcount(unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(k, v)))));
+        } else {
+            __m256i v = _mm256_set1_epi32(int32_t(x));
+            if constexpr(!is_signed) {
+                __m256i const bias = _mm256_set1_epi32(INT32_MIN);
+                k = _mm256_xor_si256(k, bias);
+                v = _mm256_xor_si256(v, bias);
+            }
+            if constexpr(strict) r += std::popcount(unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, k)))));
+            else                 r += 8 - std::popcount(unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(k, v)))));
+        }
+    }
+    return r;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    // each comparison yields all ones for the matching lanes, which we shift down to count them
+    size_t r = 0;
+    for(size_t q = 0; q < 4; q++) {
+        if constexpr(is_64) {
+            uint64x2_t m;
+            if constexpr(is_signed) {
+                int64x2_t const k = vld1q_s64((int64_t const*)line + 2 * q), v = vdupq_n_s64(x);
+                m = strict ? vcltq_s64(k, v) : vcleq_s64(k, v);
+            } else {
+                uint64x2_t const k = vld1q_u64((uint64_t const*)line + 2 * q), v = vdupq_n_u64(x);
+                m = strict ? vcltq_u64(k, v) : vcleq_u64(k, v);
+            }
+            r += vaddvq_u64(vshrq_n_u64(m, 63));
+        } else {
+            uint32x4_t m;
+            if constexpr(is_signed) {
+                int32x4_t const k = vld1q_s32((int32_t const*)line + 4 * q), v = vdupq_n_s32(x);
+                m = strict ? vcltq_s32(k, v) : vcleq_s32(k, v);
+            } else {
+                uint32x4_t const k = vld1q_u32((uint32_t const*)line + 4 * q), v = vdupq_n_u32(x);
+                m = strict ? vcltq_u32(k, v) : vcleq_u32(k, v);
+            }
+            r += vaddvq_u32(vshrq_n_u32(m, 31));
+        }
+    }
+    return r;
+#else
+    return 0; // nb: never called
+#endif
+}
+
+/**
+ * \brief Base for B-tree node implementations that store keys in a sorted, cache-line-aligned array searched using SIMD instructions
+ * 
+ * For integer keys of 32 or 64 bits, the rank of a key is computed by comparing it against an entire cache line of keys at once
+ * using AVX-512, AVX2 or NEON (whichever is available at compile time) and counting the matches.
+ * For this purpose, the unused slots of the array are filled with the maximum key, which never compares less than any key.
+ * Other keys fall back to a branch-free scalar scan.
+ * 
+ * Let N be the node's capacity, then the asymptotic search, insert and removal times are O(N) each,
+ * but the search touches only O(N/B) cache lines and performs O(N/B) SIMD comparisons for B keys per cache line.
+ * 
+ * \tparam Key the key type
+ * \tparam capacity_ the node's capacity
+ */
+template<std::totally_ordered Key, size_t capacity_>
+class SimdSearchBase {
+private:
+    static_assert(capacity_ < 65536);
+    using Size = typename std::conditional_t<capacity_ < 256, uint8_t, uint16_t>;
+
+    static constexpr bool simd_ = simd_rank_supported<Key>;
+    static constexpr size_t keys_per_line_ = simd_ ? cache_line_size / sizeof(Key) : 1;
+    static constexpr size_t num_slots_ = ((capacity_ + keys_per_line_ - 1) / keys_per_line_) * keys_per_line_;
+
+    alignas(cache_line_size) Key keys_[num_slots_];
+    Size size_;
+
+    // counts the contained keys that are less than (strict) or less than or equal to (non-strict) x
+    template<bool strict>
+    inline size_t rank(Key const x) const {
+        size_t r = 0;
+        if constexpr(simd_) {
+            // nb: the unused slots of the last line hold the maximum key, which is only counted in the non-strict case if x is the maximum
+            for(size_t i = 0; i < size_; i += keys_per_line_) {
+                r += simd_rank_line<strict>(keys_ + i, x);
+            }
+            if constexpr(!strict) r = std::min(r, size_t(size_));
+        } else {
+            for(size_t i = 0; i < size_; i++) {
+                r += strict ? (keys_[i] < x) : (keys_[i] <= x);
+            }
+        }
+        return r;
+    }
+
+protected:
+    inline size_t insert_key(Key const key) {
+        assert(size_ < capacity_);
+        size_t const i = rank<true>(key);
+        for(size_t j = size_; j > i; j--) keys_[j] = keys_[j-1];
+        keys_[i] = key;
+
+        ++size_;
+        return i;
+    }
+
+    inline bool erase_key(Key const key, size_t& pos) {
+        assert(size_ > 0);
+        size_t const i = rank<true>(key);
+        if(i < size_ && keys_[i] == key) {
+            pos = i;
+            for(size_t j = i; j + 1 < size_; j++) keys_[j] = keys_[j+1];
+
+            --size_;
+            if constexpr(simd_) keys_[size_] = std::numeric_limits<Key>::max();
+            return true;
+        }
+        return false;
+    }
+
+public:
+    SimdSearchBase(): size_(0) {
+        if constexpr(simd_) {
+            for(size_t i = 0; i < num_slots_; i++) keys_[i] = std::numeric_limits<Key>::max();
+        }
+    }
+
+    SimdSearchBase(const SimdSearchBase&) = default;
+    SimdSearchBase(SimdSearchBase&&) = default;
+
+    SimdSearchBase& operator=(const SimdSearchBase&) = default;
+    SimdSearchBase& operator=(SimdSearchBase&&) = default;
+
+    inline Key operator[](size_t const i) const {
+        return keys_[i];
+    }
+
+    inline ordered::internal::LocalQueryResult predecessor(Key const x) const {
+        size_t const r = rank<false>(x);
+        if(r == 0) return { false, 0 };
+        return { true, r - 1 };
+    }
+
+    inline ordered::internal::LocalQueryResult successor(Key const x) const {
+        size_t const r = rank<true>(x);
+        if(r == size_) return { false, 0 };
+        return { true, r };
+    }
+
+    inline size_t size() const { return size_; }
+} __attribute__((__packed__));
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * ordered/btree/internal/simd_search_set.hpp
+ * part of pdinklag/ordered
+ * 
+ * MIT License
+ * 
+ * Copyright (c) 2023 Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _ORDERED_BTREE_INTERNAL_SIMD_SEARCH_SET_HPP
+#define _ORDERED_BTREE_INTERNAL_SIMD_SEARCH_SET_HPP
+
+#include "simd_search_base.hpp"
+
+namespace ordered::btree::internal {
+
+/**
+ * \brief B-tree node implementation that stores keys in a sorted, cache-line-aligned array searched using SIMD instructions
+ * 
+ * See \ref SimdSearchBase for details on the search.
+ * 
+ * \tparam Key the key type
+ * \tparam capacity_ the node's capacity
+ */
+template<std::totally_ordered Key_, size_t capacity_>
+class SimdSearchSet : public SimdSearchBase<Key_, capacity_> {
+public:
+    static constexpr size_t capacity() { return capacity_; }
+    using Key = Key_;
+    struct Value{};
+
+    SimdSearchSet() {
+    }
+
+    SimdSearchSet(const SimdSearchSet&) = default;
+    SimdSearchSet(SimdSearchSet&&) = default;
+
+    SimdSearchSet& operator=(const SimdSearchSet&) = default;
+    SimdSearchSet& operator=(SimdSearchSet&&) = default;
+
+    inline Value value([[maybe_unused]] size_t const i) const {
+        return Value{};
+    }
+
+    inline void insert(Key const key) {
+        this->insert_key(key);
+    }
+
+    inline void insert(Key const key, [[maybe_unused]] Value const value) {
+        this->insert_key(key);
+    }
+
+    inline bool erase(Key const key, [[maybe_unused]] Value& value) {
+        return this->erase(key);
+    }
+
+    inline bool erase(Key const key) {
+        size_t discard;
+        return this->erase_key(key, discard);
+    }
+} __attribute__((__packed__));
+
+}
+
+#endif
@@ -29,7 +29,7 @@
 #define _ORDERED_BTREE_MAP_HPP
 
 #include "internal/btree_impl.hpp"
-#include "internal/linear_search_map.hpp"
+#include "internal/simd_search_map.hpp"
 
 namespace ordered::btree {
 
@@ -37,13 +37,15 @@ namespace ordered::btree {
  * \brief An associative B-tree
  * 
  * The degree must be an odd number.
+ * Nodes store their keys in cache-line-aligned arrays searched using SIMD instructions and store their child pointers inline.
+ * They are allocated from a pool, so that freed nodes are recycled and destruction releases all nodes at once.
  * 
  * \tparam Key the key type
  * \tparam Value the value type
  * \tparam degree the B-tree node degree
  */
 template<std::totally_ordered Key, typename Value, size_t degree = 65>
-using Map = internal::BTree<internal::LinearSearchMap<Key, Value, degree - 1>>;
+using Map = internal::BTree<internal::SimdSearchMap<Key, Value, degree - 1>, true, internal::PoolAllocator>;
 
 }
 
@@ -29,7 +29,7 @@
 #define _ORDERED_BTREE_SET_HPP
 
 #include "internal/btree_impl.hpp"
-#include "internal/linear_search_set.hpp"
+#include "internal/simd_search_set.hpp"
 
 namespace ordered::btree {
 
@@ -37,12 +37,14 @@ namespace ordered::btree {
  * \brief A B-tree
  * 
  * The degree must be an odd number.
+ * Nodes store their keys in cache-line-aligned arrays searched using SIMD instructions and store their child pointers inline.
+ * They are allocated from a pool, so that freed nodes are recycled and destruction releases all nodes at once.
  * 
  * \tparam Key the key type
  * \tparam degree the B-tree node degree
  */
 template<std::totally_ordered Key, size_t degree = 65>
-using Set = internal::BTree<internal::LinearSearchSet<Key, degree - 1>>;
+using Set = internal::BTree<internal::SimdSearchSet<Key, degree - 1>, true, internal::PoolAllocator>;
 
 }
 
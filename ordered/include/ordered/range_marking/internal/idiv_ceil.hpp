@@ -32,7 +32,7 @@
 
 namespace ordered::range_marking::internal {
     static constexpr size_t idiv_ceil(size_t const a, size_t const b) {
-        return ((a + b) - size_t(1) / b);
+        return (a + b - size_t(1)) / b;
     }
 }
 
@@ -102,7 +102,7 @@ public:
      * \param max_key the maximum possible key to be inserted into the container
      */
     RangeMarker(Key const max_key)
-        : num_buckets_(idiv_ceil(max_key, sampling_)),
+        : num_buckets_(idiv_ceil(size_t(max_key) + 1, sampling_)),
           buckets_(std::make_unique<BucketImpl*[]>(num_buckets_)),
           max_bucket_num_(0),
           size_(0) {
@@ -125,6 +125,7 @@ public:
             }
         }
         max_bucket_num_ = 0;
+        size_ = 0;
     }
 
     /**
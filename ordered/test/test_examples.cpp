@@ -25,12 +25,27 @@
  * SOFTWARE.
  */
 
-#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#define DOCTEST_CONFIG_IMPLEMENT
 #include "doctest.h"
 
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <ordered/bit_trie.hpp>
 #include <ordered/btree.hpp>
+#include <ordered/btree/internal/linear_search_map.hpp>
 #include <ordered/range_marking.hpp>
 
+// when built with an instruction set enabled to cover the SIMD rank search, ORDERED_TEST_SIMD names it (see main)
+#ifdef ORDERED_TEST_SIMD
+static_assert(ordered::btree::internal::simd_rank_supported<int>, "the SIMD rank search is not enabled");
+#endif
+
 namespace ordered::test {
 
 template<typename Set>
@@ -135,7 +150,94 @@ void test_map(Map& map) {
     { auto const r = map.successor(13); CHECK(!r.exists); }
 }
 
+// checks the rank search of a cache line against a scalar count, including ties and the extreme keys used for unused slots
+template<typename Key>
+void test_simd_rank_line() {
+    using namespace ordered::btree::internal;
+    constexpr size_t keys_per_line = cache_line_size / sizeof(Key);
+    constexpr Key lo = std::numeric_limits<Key>::min();
+    constexpr Key hi = std::numeric_limits<Key>::max();
+
+    std::mt19937_64 gen(sizeof(Key));
+    for(size_t round = 0; round < 200; round++) {
+        alignas(cache_line_size) Key line[keys_per_line];
+        for(auto& k : line) {
+            switch(gen() % 4) {
+                case 0: k = Key(gen() % 8); break; // nb: ties
+                case 1: k = (gen() % 2) ? lo : hi; break;
+                default: k = Key(gen()); break;
+            }
+        }
+        std::sort(line, line + keys_per_line);
+
+        std::vector<Key> queries = { lo, Key(lo + 1), Key(0), Key(1), Key(hi - 1), hi };
+        for(auto const k : line) queries.push_back(k);
+        for(size_t q = 0; q < 16; q++) queries.push_back(Key(gen()));
+
+        for(auto const x : queries) {
+            size_t less = 0, less_equal = 0;
+            for(auto const k : line) {
+                less += (k < x);
+                less_equal += (k <= x);
+            }
+            CHECK(simd_rank_line<true>(line, x) == less);
+            CHECK(simd_rank_line<false>(line, x) == less_equal);
+        }
+    }
+}
+
+// inserts and erases random keys in a B-tree with small nodes and checks predecessor queries against a sorted array
+template<typename Key>
+void test_btree_random() {
+    ordered::btree::Map<Key, Key, 17> map;
+    std::vector<Key> keys;
+
+    std::mt19937_64 gen(sizeof(Key) + std::is_signed_v<Key>);
+    auto random_key = [&](){ return Key(gen() % 2 ? gen() : gen() % 1000); };
+    for(size_t i = 0; i < 4000; i++) {
+        Key const key = random_key();
+        if(!std::binary_search(keys.begin(), keys.end(), key)) {
+            map.insert(key, Key(~key));
+            keys.insert(std::upper_bound(keys.begin(), keys.end(), key), key);
+        }
+        if(i % 3 == 0) {
+            Key const erase = keys[gen() % keys.size()];
+            CHECK(map.erase(erase));
+            keys.erase(std::lower_bound(keys.begin(), keys.end(), erase));
+        }
+    }
+    CHECK(map.size() == keys.size());
+
+    for(size_t q = 0; q < 4000; q++) {
+        Key const x = random_key();
+        auto const next = std::upper_bound(keys.begin(), keys.end(), x);
+        auto const r = map.predecessor(x);
+        CHECK(r.exists == (next != keys.begin()));
+        if(r.exists) {
+            CHECK(r.key == *(next - 1));
+            CHECK(r.value == Key(~r.key));
+        }
+    }
+}
+
 TEST_SUITE("ordered") {
+    TEST_CASE("btree::internal::simd_rank_line") {
+        // nb: the SIMD rank search is only compiled if an instruction set supporting it is enabled
+        if constexpr(ordered::btree::internal::simd_rank_supported<int>) {
+            test_simd_rank_line<int32_t>();
+            test_simd_rank_line<uint32_t>();
+            test_simd_rank_line<int64_t>();
+            test_simd_rank_line<uint64_t>();
+        }
+    }
+
+    TEST_CASE("btree::Map random insertions and removals") {
+        test_btree_random<int32_t>();
+        test_btree_random<uint32_t>();
+        test_btree_random<int64_t>();
+        test_btree_random<uint64_t>();
+    }
+
     TEST_CASE("btree::Set") {
         ordered::btree::Set<int> set;
         test_set(set);
@@ -146,6 +248,100 @@ TEST_SUITE("ordered") {
         test_map(map);
     }
 
+    TEST_CASE("btree::Map with linear search nodes") {
+        ordered::btree::internal::BTree<ordered::btree::internal::LinearSearchMap<int, int, 64>> map;
+        test_map(map);
+    }
+
+    TEST_CASE("btree::Map with heap-allocated nodes") {
+        ordered::btree::internal::BTree<ordered::btree::internal::SimdSearchMap<int, int, 4>, false, ordered::btree::internal::HeapAllocator> map;
+        test_map(map);
+    }
+
+    TEST_CASE("btree::Set multiple levels") {
+        // insert enough keys to split and merge nodes across several levels, including the extreme keys
+        ordered::btree::Set<int, 5> set;
+        set.insert(INT_MAX);
+        set.insert(INT_MIN);
+        for(int i = 0; i < 1000; i++) set.insert(i * 3);
+        CHECK(set.size() == 1002);
+        CHECK(set.min_key() == INT_MIN);
+        CHECK(set.max_key() == INT_MAX);
+        { auto const r = set.predecessor(1000); CHECK(r.exists); CHECK(r.key == 999); }
+        { auto const r = set.successor(1000); CHECK(r.exists); CHECK(r.key == 1002); }
+        { auto const r = set.successor(2998); CHECK(r.exists); CHECK(r.key == INT_MAX); }
+        { auto const r = set.predecessor(INT_MAX - 1); CHECK(r.exists); CHECK(r.key == 2997); }
+
+        for(int i = 0; i < 1000; i += 2) CHECK(set.erase(i * 3));
+        CHECK(set.size() == 502);
+        CHECK(!set.contains(996));
+        { auto const r = set.predecessor(998); CHECK(r.exists); CHECK(r.key == 993); }
+        { auto const r = set.successor(1000); CHECK(r.exists); CHECK(r.key == 1005); }
+
+        CHECK(set.erase(INT_MAX));
+        { auto const r = set.successor(2998); CHECK(!r.exists); }
+        CHECK(set.max_key() == 2997);
+
+        // clearing recycles all nodes, after which the set can be reused
+        set.clear();
+        CHECK(set.empty());
+        for(int i = 0; i < 100; i++) set.insert(i);
+        CHECK(set.size() == 100);
+        { auto const r = set.predecessor(1000); CHECK(r.exists); CHECK(r.key == 99); }
+    }
+
+    TEST_CASE("btree::internal::PoolAllocator recycling") {
+        ordered::btree::internal::PoolAllocator<int, 16> alloc;
+        std::vector<int*> nodes;
+        for(int i = 0; i < 111; i++) nodes.push_back(alloc.allocate()); // nb: fills slabs of 1, 2, 4, 8 and six times 16 nodes
+        size_t const num_slabs = alloc.num_slabs();
+
+        // recycling keeps the slabs and hands out the same storage again, in the same order
+        alloc.recycle();
+        for(int i = 0; i < 111; i++) CHECK(alloc.allocate() == nodes[i]);
+        CHECK(alloc.num_slabs() == num_slabs);
+
+        // further allocations add new slabs
+        alloc.allocate();
+        CHECK(alloc.num_slabs() == num_slabs + 1);
+    }
+
+    TEST_CASE("btree::Map bulk construction") {
+        // construct from sorted keys with half-full nodes
+        std::vector<int> keys, values;
+        for(int i = 0; i < 1000; i++) {
+            keys.push_back(i * 2);
+            values.push_back(i);
+        }
+        ordered::btree::Map<int, int, 5> map(keys, values, 0.5);
+        CHECK(map.size() == 1000);
+        CHECK(map.min_key() == 0);
+        CHECK(map.max_key() == 1998);
+        { auto const r = map.predecessor(501); CHECK(r.exists); CHECK(r.key == 500); CHECK(r.value == 250); }
+        { auto const r = map.successor(501); CHECK(r.exists); CHECK(r.key == 502); CHECK(r.value == 251); }
+
+        // the constructed tree supports updates
+        map.insert(501, -1);
+        CHECK(map.erase(500));
+        { auto const r = map.predecessor(501); CHECK(r.exists); CHECK(r.key == 501); CHECK(r.value == -1); }
+
+        // erase a small range one by one and a large range by rebuilding
+        CHECK(map.erase_range(10, 20) == 6);
+        CHECK(map.size() == 994);
+        { auto const r = map.successor(9); CHECK(r.exists); CHECK(r.key == 22); }
+        CHECK(map.erase_range(100, 1899) == 900);
+        CHECK(map.size() == 94);
+        { auto const r = map.predecessor(1899); CHECK(r.exists); CHECK(r.key == 98); }
+        { auto const r = map.successor(100); CHECK(r.exists); CHECK(r.key == 1900); CHECK(r.value == 950); }
+        CHECK(map.erase_range(2000, 3000) == 0);
+
+        // construct an empty set
+        ordered::btree::Set<int> set(std::span<int const>{});
+        CHECK(set.empty());
+        set.insert(1);
+        CHECK(set.contains(1));
+    }
+
     TEST_CASE("range_marking::Set") {
         ordered::range_marking::Set<unsigned int> set(15);
         test_set(set);
@@ -155,6 +351,60 @@ TEST_SUITE("ordered") {
         ordered::range_marking::Map<unsigned int, unsigned int> map(15);
         test_map(map);
     }
+
+    TEST_CASE("range_marking::Set bucket boundaries") {
+        // the maximum key is the first key of the last bucket
+        ordered::range_marking::Set<unsigned int, 64> set(128);
+        set.insert(128);
+        set.insert(64);
+        set.insert(0);
+        CHECK(set.size() == 3);
+        CHECK(set.max_key() == 128);
+        { auto const r = set.predecessor(127); CHECK(r.exists); CHECK(r.key == 64); }
+        { auto const r = set.successor(65); CHECK(r.exists); CHECK(r.key == 128); }
+
+        set.clear();
+        CHECK(set.empty());
+    }
+
+    TEST_CASE("bit_trie::Set") {
+        ordered::bit_trie::Set<unsigned int> set(15);
+        test_set(set);
+    }
+
+    TEST_CASE("bit_trie::Map") {
+        ordered::bit_trie::Map<unsigned int, unsigned int> map(15);
+        test_map(map);
+    }
+
+    TEST_CASE("bit_trie::Set multiple levels") {
+        // a universe of 2^18 keys requires three levels
+        ordered::bit_trie::Set<unsigned int> set((1U << 18) - 1);
+        set.insert(5);
+        set.insert(4096);
+        set.insert(200000);
+        CHECK(set.min_key() == 5);
+        CHECK(set.max_key() == 200000);
+        { auto const r = set.predecessor(4095); CHECK(r.exists); CHECK(r.key == 5); }
+        { auto const r = set.predecessor(199999); CHECK(r.exists); CHECK(r.key == 4096); }
+        { auto const r = set.predecessor(4); CHECK(!r.exists); }
+        { auto const r = set.successor(6); CHECK(r.exists); CHECK(r.key == 4096); }
+        { auto const r = set.successor(4097); CHECK(r.exists); CHECK(r.key == 200000); }
+        { auto const r = set.successor(200001); CHECK(!r.exists); }
+
+        CHECK(set.erase(4096));
+        CHECK(!set.erase(4096));
+        { auto const r = set.successor(6); CHECK(r.exists); CHECK(r.key == 200000); }
+        { auto const r = set.predecessor(199999); CHECK(r.exists); CHECK(r.key == 5); }
+    }
+}
+
 }
 
+int main(int argc, char** argv) {
+#if defined(ORDERED_TEST_SIMD) && (defined(__x86_64__) || defined(__i386__))
+    // skip the test if the machine lacks the instruction set it was built for
+    if(!__builtin_cpu_supports(ORDERED_TEST_SIMD)) return 77;
+#endif
+    return doctest::Context(argc, argv).run();
 }
@@ -30,6 +30,8 @@
 
 #include <ordered/btree/internal/linear_search_map.hpp>
 #include <ordered/btree/internal/linear_search_set.hpp>
+#include <ordered/btree/internal/simd_search_set.hpp>
+#include <ordered/range_marking/internal/idiv_ceil.hpp>
 
 constexpr size_t small = 255;
 constexpr size_t large = 256;
@@ -46,6 +48,13 @@ static_assert(sizeof(ordered::btree::internal::LinearSearchSet<Key, large>) == (
 static_assert(sizeof(ordered::btree::internal::LinearSearchMap<Key, Value, small>) == (small * (key_size + value_size) + sizeof(uint8_t)));
 static_assert(sizeof(ordered::btree::internal::LinearSearchMap<Key, Value, large>) == (large * (key_size + value_size) + sizeof(uint16_t)));
 
+static_assert(alignof(ordered::btree::internal::SimdSearchSet<Key, small>) == ordered::btree::internal::cache_line_size);
+static_assert(sizeof(ordered::btree::internal::SimdSearchSet<Key, small>) % ordered::btree::internal::cache_line_size == 0);
+
+static_assert(ordered::range_marking::internal::idiv_ceil(4096, 64) == 64);
+static_assert(ordered::range_marking::internal::idiv_ceil(4097, 64) == 65);
+static_assert(ordered::range_marking::internal::idiv_ceil(1, 64) == 1);
+
 int main() {
     // we compiled, so we passed
     return 0;
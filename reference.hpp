@@ -0,0 +1,561 @@
+/**
+ * reference.hpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _LZEND_REFERENCE_HPP
+#define _LZEND_REFERENCE_HPP
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "decompress.hpp"
+#include "lzend.hpp"
+#include "mapped_file.hpp"
+
+namespace lzend {
+
+class Reference;
+
+namespace internal {
+
+constexpr char reference_magic[4] = { 'L', 'Z', 'R', 2 };
+
+// the header of a reference file, which is followed by the phrase end positions, the index (see Reference) and the text
+struct ReferenceHeader {
+    char magic[4];
+    uint32_t reserved;
+    uint64_t n;
+    uint64_t z;
+    uint64_t whole_rank;
+};
+
+static_assert(sizeof(ReferenceHeader) == 32);
+
+// the layout of a reference file of the given text length and number of phrases, in which all arrays are aligned to their entries
+struct ReferenceLayout {
+    size_t ends, psi, lcp, mark_ranks, mark_phrases, bwt, text, size;
+
+    ReferenceLayout(size_t const n, size_t const z) {
+        ends = sizeof(ReferenceHeader);
+        psi = ends + z * sizeof(uint64_t);
+        lcp = psi + n * sizeof(int32_t);
+        mark_ranks = lcp + n * sizeof(int32_t);
+        mark_phrases = mark_ranks + z * sizeof(int32_t);
+        bwt = mark_phrases + z * sizeof(int32_t);
+        text = bwt + n;
+        size = text + n;
+    }
+};
+
+template<std::signed_integral Index>
+class ReferenceSource;
+
+}
+
+// a reference dictionary, i.e., a text along with the end positions of the phrases of its LZ-End parsing, against which inputs can be parsed
+// such that their phrases may copy from the reference, e.g., when compressing many versions of similar files
+//
+// the reference is parsed only once and can be stored to a file, which is memory-mapped when it is loaded
+// parsing an input against the reference yields the phrases of the input as if it were parsed as a continuation of the reference
+//
+// to find the reference's phrases that share the longest suffixes with the input's prefixes without building a suffix array of both,
+// the reference comes with an index over its reversed text, which is computed once and stored along with it:
+// - psi, which maps the rank of each suffix to that of the suffix one position further (or -1 for the last one),
+// - the LCP array, which answers range minimum queries,
+// - the Burrows-Wheeler transform, which answers rank queries for computing the suffix array rank of any prepended string,
+// - and the phrase ends' suffix array ranks in ascending order along with their phrase numbers
+// references are limited to 2 GiB, so the index consists of 32-bit entries regardless of the index type used for the inputs
+class Reference {
+private:
+    template<std::signed_integral> friend class internal::ReferenceSource;
+
+    static constexpr size_t super_bits = 16; // the positions per superblock of the rank directory
+    static constexpr size_t block_bits = 9; // the positions per block of the rank directory
+
+    MappedFile file_;
+    std::unique_ptr<char[]> data_; // a computed reference in the same layout as the file
+
+    // views of the file or the computed data, which both stay in place when moved
+    char const* bytes_;
+    size_t size_bytes_;
+    std::string_view text_;
+    std::span<uint64_t const> ends_;
+    std::span<int32_t const> psi_, lcp_, mark_ranks_, mark_phrases_;
+    uint8_t const* bwt_;
+    int32_t whole_rank_; // the rank of the whole reversed text, which has no preceding character; its BWT entry is zero
+
+    // the index built when constructing or loading the reference
+    std::array<int32_t, 257> counts_; // the number of suffixes starting with a character smaller than each of 0..256
+    rmq::RMQ<int32_t, 64, uint32_t> rmq_;
+    ordered::btree::Map<int32_t, int32_t> marks_;
+    std::array<int16_t, 256> code_; // the dense code of each character occurring in the BWT, or -1
+    size_t sigma_;
+    std::vector<uint32_t> super_counts_; // the occurrences of each code before each superblock
+    std::vector<uint16_t> block_counts_; // the occurrences of each code before each block, relative to its superblock
+    bool good_;
+
+    // sets the views to the given data in the file layout and builds the index, returning false if the data is not a valid reference
+    bool init(char const* const bytes, size_t const size) {
+        if(size < sizeof(internal::ReferenceHeader)) return false;
+        auto const& h = *(internal::ReferenceHeader const*)bytes;
+        if(std::memcmp(h.magic, internal::reference_magic, 4) != 0 || h.n > size_t(INT32_MAX) || h.z > h.n || (h.n > 0) != (h.z > 0)) return false;
+
+        internal::ReferenceLayout const layout(h.n, h.z);
+        if(size != layout.size || (h.n > 0 && h.whole_rank >= h.n)) return false;
+
+        bytes_ = bytes;
+        size_bytes_ = size;
+        text_ = std::string_view(bytes + layout.text, h.n);
+        ends_ = std::span((uint64_t const*)(bytes + layout.ends), h.z);
+        psi_ = std::span((int32_t const*)(bytes + layout.psi), h.n);
+        lcp_ = std::span((int32_t const*)(bytes + layout.lcp), h.n);
+        mark_ranks_ = std::span((int32_t const*)(bytes + layout.mark_ranks), h.z);
+        mark_phrases_ = std::span((int32_t const*)(bytes + layout.mark_phrases), h.z);
+        bwt_ = (uint8_t const*)(bytes + layout.bwt);
+        whole_rank_ = h.whole_rank;
+
+        // validate what the parsing and decompression rely on, so that a corrupt file cannot cause out-of-bounds accesses
+        int32_t const n = h.n;
+        int32_t const z = h.z;
+        for(int32_t j = 0; j < z; j++) {
+            if(ends_[j] >= uint64_t(n) || (j > 0 && ends_[j] <= ends_[j-1])) return false;
+            if(mark_ranks_[j] < 0 || mark_ranks_[j] >= n || (j > 0 && mark_ranks_[j] <= mark_ranks_[j-1])) return false;
+            if(mark_phrases_[j] < 0 || mark_phrases_[j] >= z) return false;
+        }
+        if(z > 0 && ends_[z-1] != uint64_t(n - 1)) return false;
+        for(int32_t j = 0; j < n; j++) {
+            if(psi_[j] < -1 || psi_[j] >= n) return false;
+        }
+
+        // character counts, which the BWT must match except for the first character of the text and the whole reversed text's entry
+        counts_.fill(0);
+        for(int32_t i = 0; i < n; i++) ++counts_[uint8_t(text_[i]) + 1];
+        std::array<int32_t, 256> bwt_counts = {};
+        for(int32_t j = 0; j < n; j++) ++bwt_counts[bwt_[j]];
+        for(size_t c = 0; c < 256; c++) {
+            if(bwt_counts[c] != counts_[c + 1] - (n > 0 && c == uint8_t(text_[0])) + (n > 0 && c == 0)) return false;
+        }
+        if(n > 0 && bwt_[whole_rank_] != 0) return false;
+        for(size_t c = 1; c <= 256; c++) counts_[c] += counts_[c-1];
+
+        rmq_ = rmq::RMQ<int32_t, 64, uint32_t>(lcp_.data(), n);
+        if(z > 0) marks_ = ordered::btree::Map<int32_t, int32_t>(mark_ranks_, mark_phrases_);
+
+        // rank directory over the BWT
+        code_.fill(-1);
+        sigma_ = 0;
+        for(size_t c = 0; c < 256; c++) {
+            if(bwt_counts[c] > 0) code_[c] = sigma_++;
+        }
+        size_t const num_blocks = (size_t(n) >> block_bits) + 1;
+        size_t const num_supers = (size_t(n) >> super_bits) + 1;
+        super_counts_.assign(num_supers * sigma_, 0);
+        block_counts_.assign(num_blocks * sigma_, 0);
+        std::vector<uint32_t> count(sigma_, 0);
+        for(size_t j = 0; j <= size_t(n); j++) {
+            if((j & ((size_t(1) << super_bits) - 1)) == 0) std::copy(count.begin(), count.end(), super_counts_.begin() + (j >> super_bits) * sigma_);
+            if((j & ((size_t(1) << block_bits) - 1)) == 0) {
+                auto const* super = super_counts_.data() + (j >> super_bits) * sigma_;
+                for(size_t c = 0; c < sigma_; c++) block_counts_[(j >> block_bits) * sigma_ + c] = count[c] - super[c];
+            }
+            if(j < size_t(n)) ++count[code_[bwt_[j]]];
+        }
+        return true;
+    }
+
+    // the number of occurrences of the given character in the BWT before the given rank, not counting the whole reversed text's entry
+    int32_t occ(uint8_t const c, int32_t const r) const {
+        if(code_[c] < 0) return 0;
+        size_t const code = code_[c];
+        auto count = [&](size_t const block){
+            return int32_t(super_counts_[(block >> (super_bits - block_bits)) * sigma_ + code] + block_counts_[block * sigma_ + code]);
+        };
+
+        // scan from the nearest block boundary
+        // nb: plain loops, which the compiler vectorizes
+        size_t block = (size_t(r) + (size_t(1) << (block_bits - 1))) >> block_bits;
+        size_t const boundary = block << block_bits;
+        int32_t k;
+        if(boundary <= size_t(r)) {
+            uint32_t scan = 0;
+            for(size_t j = boundary; j < size_t(r); j++) scan += (bwt_[j] == c);
+            k = count(block) + int32_t(scan);
+        } else if(boundary <= size_t(size())) {
+            uint32_t scan = 0;
+            for(size_t j = r; j < boundary; j++) scan += (bwt_[j] == c);
+            k = count(block) - int32_t(scan);
+        } else {
+            block--;
+            uint32_t scan = 0;
+            for(size_t j = block << block_bits; j < size_t(r); j++) scan += (bwt_[j] == c);
+            k = count(block) + int32_t(scan);
+        }
+        return k - (c == 0 && r > whole_rank_);
+    }
+
+    // the minimum LCP value in the given interval of the reversed text's suffix array
+    int32_t lcp_min(int32_t const i, int32_t const j) const {
+        return lcp_[rmq_(i, j)];
+    }
+
+    // allocates the data of a computed reference with the given text length and number of phrases, initializing its header
+    char* allocate(size_t const n, size_t const z, size_t const whole_rank) {
+        internal::ReferenceHeader h = {};
+        std::memcpy(h.magic, internal::reference_magic, 4);
+        h.n = n;
+        h.z = z;
+        h.whole_rank = whole_rank;
+
+        data_ = std::make_unique_for_overwrite<char[]>(internal::ReferenceLayout(n, z).size);
+        std::memcpy(data_.get(), &h, sizeof(h));
+        return data_.get();
+    }
+
+    void reset() {
+        bytes_ = nullptr;
+        size_bytes_ = 0;
+        text_ = {};
+        ends_ = {};
+        psi_ = lcp_ = mark_ranks_ = mark_phrases_ = {};
+        bwt_ = nullptr;
+        whole_rank_ = 0;
+        counts_.fill(0);
+        code_.fill(-1);
+        sigma_ = 0;
+    }
+
+public:
+    // an empty reference, against which inputs are parsed as usual
+    Reference() : good_(false) {
+        reset();
+        good_ = init(allocate(0, 0, 0), internal::ReferenceLayout(0, 0).size);
+    }
+
+    // the reference with the given text and LZ-End parsing of it, whose index is constructed using the given number of threads
+    // throws std::length_error if the text exceeds 2 GiB
+    template<std::signed_integral Index>
+    Reference(std::string_view const text, std::span<Phrase<Index> const> const parsing, int const threads = 1) : good_(false) {
+        reset();
+        if(text.size() > size_t(INT32_MAX)) throw std::length_error("references beyond 2 GiB are not supported");
+        int32_t const n = text.size();
+        size_t const z = parsing.size();
+        internal::ReferenceLayout const layout(n, z);
+        char* const data = allocate(n, z, 0);
+
+        // phrase end positions
+        auto* const ends = (uint64_t*)(data + layout.ends);
+        uint64_t end = 0;
+        for(size_t j = 0; j < z; j++) {
+            end += parsing[j].len;
+            ends[j] = end - 1;
+        }
+        assert(end == text.size());
+
+        // suffix and LCP arrays of the reversed text
+        auto* const psi = (int32_t*)(data + layout.psi);
+        auto* const lcp = (int32_t*)(data + layout.lcp);
+        auto* const bwt = (uint8_t*)(data + layout.bwt);
+        if(n > 0) {
+            auto* const sa = psi; // nb: psi is computed in place over the suffix array
+            auto const rs = std::make_unique_for_overwrite<uint8_t[]>(n);
+            for(int32_t i = 0; i < n; i++) rs[n-1-i] = text[i];
+            internal::compute_sa(rs.get(), sa, n, threads);
+
+            auto const plcp = std::make_unique_for_overwrite<int32_t[]>(n);
+            internal::compute_plcp(rs.get(), sa, plcp.get(), n, threads);
+            internal::compute_lcp(plcp.get(), sa, lcp, n, threads);
+
+            // BWT
+            for(int32_t j = 0; j < n; j++) {
+                if(sa[j] == 0) ((internal::ReferenceHeader*)data)->whole_rank = j;
+                bwt[j] = sa[j] > 0 ? rs[sa[j] - 1] : 0;
+            }
+
+            // psi, using the PLCP array's memory for the ISA
+            int32_t* const isa = plcp.get();
+            for(int32_t j = 0; j < n; j++) isa[sa[j]] = j;
+            for(int32_t j = 0; j < n; j++) psi[j] = sa[j] + 1 < n ? isa[sa[j] + 1] : -1;
+
+            // the ranks of the phrase ends, i.e., of the suffixes of the reversed text where the reversed phrases begin
+            std::vector<std::pair<int32_t, int32_t>> marks(z);
+            for(size_t j = 0; j < z; j++) marks[j] = { isa[n - 1 - ends[j]], int32_t(j) };
+            std::sort(marks.begin(), marks.end());
+            for(size_t j = 0; j < z; j++) {
+                ((int32_t*)(data + layout.mark_ranks))[j] = marks[j].first;
+                ((int32_t*)(data + layout.mark_phrases))[j] = marks[j].second;
+            }
+        }
+
+        std::memcpy(data + layout.text, text.data(), n);
+        good_ = init(data, layout.size);
+        assert(good_);
+    }
+
+    // maps the reference stored in the given file; if the file cannot be mapped or is not a reference, the result is not good
+    explicit Reference(std::string const& path) : file_(path, false), good_(false) {
+        reset();
+        if(file_.good()) good_ = init(file_.data(), file_.size());
+        if(!good_) reset();
+    }
+
+    Reference(Reference&&) = default;
+    Reference& operator=(Reference&&) = default;
+
+    Reference(Reference const&) = delete;
+    Reference& operator=(Reference const&) = delete;
+
+    // computes the LZ-End parsing of the given text and returns the reference for it
+    // throws std::length_error if the text exceeds 2 GiB
+    template<
+        std::signed_integral Index = int32_t,
+        typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+        typename Marked = ordered::btree::Map<Index, Index>,
+        typename Stats = NoStats>
+    static Reference compute(std::string_view const text, Options const& options, Stats& stats) {
+        if(text.size() > size_t(INT32_MAX)) throw std::length_error("references beyond 2 GiB are not supported");
+        auto const parsing = parse<Index, RMQ, Marked>(text, options, stats);
+        return Reference(text, std::span<Phrase<Index> const>(parsing), internal::num_threads(options));
+    }
+
+    template<
+        std::signed_integral Index = int32_t,
+        typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+        typename Marked = ordered::btree::Map<Index, Index>>
+    static Reference compute(std::string_view const text, Options const& options = {}) {
+        NoStats stats;
+        return compute<Index, RMQ, Marked>(text, options, stats);
+    }
+
+    // stores the reference, including its index, to the given file, returning false on failure
+    bool save(std::string const& path) const {
+        assert(good_);
+        int const fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if(fd < 0) return false;
+        bool const ok = internal::write_fully(fd, bytes_, size_bytes_, 0);
+        return ::close(fd) == 0 && ok;
+    }
+
+    // tells whether the reference has been loaded successfully
+    bool good() const { return good_; }
+
+    // the text of the reference
+    std::string_view text() const { return text_; }
+
+    // the end positions of the reference's phrases in ascending order
+    std::span<uint64_t const> ends() const { return ends_; }
+
+    size_t size() const { return text_.size(); }
+    size_t num_phrases() const { return ends_.size(); }
+};
+
+namespace internal {
+
+// the phrases of a reference as a source for parse_range (see NoSource)
+//
+// the source maintains the suffix array rank r of the current reversed prefix P of the input among the suffixes of the reversed reference,
+// i.e., the number of suffixes that are lexicographically smaller than or equal to P, as well as the longest common prefixes of P
+// with the suffixes of rank r-1 and r, which are the longest over all suffixes smaller and greater than P, respectively
+// prepending a character c to P is a backward search step, whose result rank is the number of suffixes starting with a smaller character
+// plus the number of those starting with c whose remainder, the suffix one position further, is smaller than or equal to P;
+// the new common prefixes then follow from psi, which gives the rank of that remainder for the new neighbours, and range minimum queries
+template<std::signed_integral Index>
+class ReferenceSource {
+private:
+    Reference const* ref_;
+    int32_t r_;
+    int32_t lo_;
+    int32_t hi_;
+
+public:
+    static constexpr bool enabled = true;
+
+    ReferenceSource(Reference const& ref) : ref_(&ref), r_(0), lo_(0), hi_(0) {
+        assert(ref.size() > 0);
+    }
+
+    size_t num_phrases() const { return ref_->num_phrases(); }
+
+    void advance(char const ch) {
+        auto const& ref = *ref_;
+        uint8_t const c = ch;
+        int32_t const first = ref.counts_[c];
+        int32_t const end = ref.counts_[c + 1];
+
+        // nb: the suffix consisting only of the reversed text's last character has the empty suffix as its remainder, which is smaller than P
+        int32_t const r = first + ref.occ(c, r_) + (c == uint8_t(ref.text_[0]));
+
+        // the greatest suffix starting with c that is smaller than or equal to cP, if any, has a remainder of rank k < r
+        int32_t lo = 0;
+        if(r > first) {
+            int32_t const k = ref.psi_[r - 1];
+            lo = 1 + (k < 0 ? 0 : k == r_ - 1 ? lo_ : std::min(lo_, ref.lcp_min(k + 1, r_ - 1)));
+        }
+
+        // the smallest suffix starting with c that is greater than cP, if any, has a remainder of rank k >= r
+        int32_t hi = 0;
+        if(r < end) {
+            int32_t const k = ref.psi_[r];
+            hi = 1 + (k == r_ ? hi_ : std::min(hi_, ref.lcp_min(r_ + 1, k)));
+        }
+
+        r_ = r;
+        lo_ = lo;
+        hi_ = hi;
+    }
+
+    template<typename Stats>
+    ExternalCandidate<Index> smaller(Index const min_len, Limits<Index> const& limits, Stats& stats) const {
+        if(r_ == 0 || lo_ < min_len) return { 0, 0 };
+        auto const& ref = *ref_;
+        stats.on_predecessor_query();
+        auto const p = ref.marks_.predecessor(r_ - 1);
+        if(!p.exists) return { 0, 0 };
+        Index const lnk = Index(p.value) - Index(ref.num_phrases());
+        if(p.key == r_ - 1) return { lnk, lo_ };
+        if(Index(r_ - 1 - p.key) > limits.max_rmq_interval) [[unlikely]] {
+            stats.on_capped_rmq_query();
+            return { lnk, 0 };
+        }
+        stats.on_rmq_query(p.key + 1, r_ - 1);
+        return { lnk, std::min(lo_, ref.lcp_min(p.key + 1, r_ - 1)) };
+    }
+
+    template<typename Stats>
+    ExternalCandidate<Index> greater(Index const min_len, Limits<Index> const& limits, Stats& stats) const {
+        auto const& ref = *ref_;
+        if(size_t(r_) >= ref.size() || hi_ < min_len) return { 0, 0 };
+        stats.on_successor_query();
+        auto const p = ref.marks_.successor(r_);
+        if(!p.exists) return { 0, 0 };
+        Index const lnk = Index(p.value) - Index(ref.num_phrases());
+        if(p.key == r_) return { lnk, hi_ };
+        if(Index(p.key - r_) > limits.max_rmq_interval) [[unlikely]] {
+            stats.on_capped_rmq_query();
+            return { lnk, 0 };
+        }
+        stats.on_rmq_query(r_ + 1, p.key);
+        return { lnk, std::min(hi_, ref.lcp_min(r_ + 1, p.key)) };
+    }
+
+    // the common suffixes with the reference grow by at most one per character, so no phrase beginning before i - max(lo, hi)
+    // can ever copy from the reference
+    Index horizon(Index const i) const {
+        return i - std::max(lo_, hi_);
+    }
+};
+
+}
+
+// computes the LZ-End parsing of the given input against the given reference, passes each phrase to the sink as soon as it is final
+// and returns the number of phrases
+//
+// the phrases are numbered after those of the reference, so that a link smaller than the reference's number of phrases refers to a phrase of the reference
+// the input is parsed as a continuation of the reference: only the input's own suffix and LCP arrays are constructed, and the reference's phrases
+// are found using its index, so the work per input does not depend on the reference's length
+// chunks and checkpoints are not supported; throws std::length_error if the phrase numbers may exceed the index type
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>,
+    typename Stats = NoStats,
+    std::invocable<Phrase<Index> const&> Sink>
+size_t parse(std::string_view const s, Reference const& ref, Sink&& sink, Options const& options, Stats& stats) {
+    assert(ref.good());
+    if(ref.size() == 0) return parse<Index, RMQ, Marked>(s, std::forward<Sink>(sink), options, stats);
+    if(ref.num_phrases() + s.size() > size_t(std::numeric_limits<Index>::max())) throw std::length_error("the phrases of the reference and the input exceed the index type");
+
+    internal::Workspace<Index, Marked, char> ws;
+    return internal::parse_text<Index, RMQ, Marked>(std::span<char const>(s.data(), s.size()), std::forward<Sink>(sink), options, stats, ws, internal::ReferenceSource<Index>(ref));
+}
+
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>,
+    std::invocable<Phrase<Index> const&> Sink>
+size_t parse(std::string_view const s, Reference const& ref, Sink&& sink, Options const& options = {}) {
+    NoStats stats;
+    return parse<Index, RMQ, Marked>(s, ref, std::forward<Sink>(sink), options, stats);
+}
+
+// computes the LZ-End parsing of the given input against the given reference and returns it
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>,
+    typename Stats = NoStats>
+std::vector<Phrase<Index>> parse(std::string_view const s, Reference const& ref, Options const& options, Stats& stats) {
+    std::vector<Phrase<Index>> parsing;
+    parse<Index, RMQ, Marked>(s, ref, [&](Phrase<Index> const& f){ parsing.push_back(f); }, options, stats);
+    return parsing;
+}
+
+template<
+    std::signed_integral Index = int32_t,
+    typename RMQ = rmq::RMQ<Index, 64, std::make_unsigned_t<Index>>,
+    typename Marked = ordered::btree::Map<Index, Index>>
+std::vector<Phrase<Index>> parse(std::string_view const s, Reference const& ref, Options const& options = {}) {
+    NoStats stats;
+    return parse<Index, RMQ, Marked>(s, ref, options, stats);
+}
+
+// decompresses a parsing computed against the given reference into a string
+template<std::signed_integral Index>
+std::string decompress(std::vector<Phrase<Index>> const& parsing, Reference const& ref) {
+    std::span<Phrase<Index> const> const span(parsing);
+    size_t const n0 = ref.size();
+    size_t const z0 = ref.num_phrases();
+
+    // nb: the sources may lie in the reference, so it precedes the decompressed text
+    auto out = std::make_unique_for_overwrite<char[]>(n0 + decompressed_length(span));
+    auto ends = std::make_unique_for_overwrite<Index[]>(z0 + parsing.size());
+    std::memcpy(out.get(), ref.text().data(), n0);
+    for(size_t j = 0; j < z0; j++) ends[j] = Index(ref.ends()[j]);
+
+    Decompressor<Index> dec(out.get(), ends.get(), n0, z0);
+    dec.decompress(span);
+    return std::string(out.get() + n0, dec.length() - n0);
+}
+
+}
+
+#endif
@@ -0,0 +1,220 @@
+/**
+ * rmq/min_scan.hpp
+ * part of pdinklag/lzend
+ *
+ * MIT License
+ *
+ * Copyright (c) Patrick Dinklage
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _RMQ_MIN_SCAN_HPP
+#define _RMQ_MIN_SCAN_HPP
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "compare.hpp"
+
+namespace rmq {
+
+// scans data[beg..end) for the leftmost minimum (or maximum), stores it in min and returns its position
+template<bool minimum, std::totally_ordered Value, std::unsigned_integral Index>
+inline Index min_scan_scalar(Value const* data, Index beg, Index const end, Value& min) {
+    Index min_pos = beg;
+    min = data[beg];
+
+    ++beg;
+    while(beg < end) {
+        if(compare_strict<minimum>(data[beg], min)) {
+            min = data[beg];
+            min_pos = beg;
+        }
+        ++beg;
+    }
+    return min_pos;
+}
+
+namespace internal {
+
+// the SIMD instruction set selected at compile time
+#if defined(__AVX512F__)
+constexpr size_t simd_lanes = 16;
+#elif defined(__AVX2__)
+constexpr size_t simd_lanes = 8;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+constexpr size_t simd_lanes = 4;
+#else
+constexpr size_t simd_lanes = 0;
+#endif
+
+// reduces data[beg..end) to its minimum (or maximum) value, requires end - beg >= simd_lanes
+template<bool minimum>
+inline int32_t simd_reduce(int32_t const* data, size_t beg, size_t const end) {
+#if defined(__AVX512F__)
+    auto const op = [](__m512i a, __m512i b){ if constexpr(minimum) return _mm512_min_epi32(a, b); else return _mm512_max_epi32(a, b); };
+    __m512i m = _mm512_loadu_si512(data + beg);
+    for(beg += simd_lanes; beg + simd_lanes <= end; beg += simd_lanes) {
+        m = op(m, _mm512_loadu_si512(data + beg));
+    }
+    m = op(m, _mm512_loadu_si512(data + end - simd_lanes)); // nb: overlapping tail
+    if constexpr(minimum) return _mm512_reduce_min_epi32(m); else return _mm512_reduce_max_epi32(m);
+#elif defined(__AVX2__)
+    auto const op = [](__m256i a, __m256i b){ if constexpr(minimum) return _mm256_min_epi32(a, b); else return _mm256_max_epi32(a, b); };
+    __m256i m = _mm256_loadu_si256((__m256i const*)(data + beg));
+    for(beg += simd_lanes; beg + simd_lanes <= end; beg += simd_lanes) {
+        m = op(m, _mm256_loadu_si256((__m256i const*)(data + beg)));
+    }
+    m = op(m, _mm256_loadu_si256((__m256i const*)(data + end - simd_lanes))); // nb: overlapping tail
+
+    // horizontal reduction
+    m = op(m, _mm256_permute2x128_si256(m, m, 1));
+    m = op(m, _mm256_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = op(m, _mm256_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm256_cvtsi256_si32(m);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    auto const op = [](int32x4_t a, int32x4_t b){ if constexpr(minimum) return vminq_s32(a, b); else return vmaxq_s32(a, b); };
+    int32x4_t m = vld1q_s32(data + beg);
+    for(beg += simd_lanes; beg + simd_lanes <= end; beg += simd_lanes) {
+        m = op(m, vld1q_s32(data + beg));
+    }
+    m = op(m, vld1q_s32(data + end - simd_lanes)); // nb: overlapping tail
+    if constexpr(minimum) return vminvq_s32(m); else return vmaxvq_s32(m);
+#else
+    return 0; // nb: never called
+#endif
+}
+
+// finds the first position in data[beg..end) that holds the given value, which must be contained
+inline size_t simd_find(int32_t const* data, size_t beg, size_t const end, int32_t const x) {
+#if defined(__AVX512F__)
+    __m512i const v = _mm512_set1_epi32(x);
+    for(; beg + simd_lanes <= end; beg += simd_lanes) {
+        auto const mask = _mm512_cmpeq_epi32_mask(v, _mm512_loadu_si512(data + beg));
+        if(mask) return beg + std::countr_zero(uint32_t(mask));
+    }
+#elif defined(__AVX2__)
+    __m256i const v = _mm256_set1_epi32(x);
+    for(; beg + simd_lanes <= end; beg += simd_lanes) {
+        auto const eq = _mm256_cmpeq_epi32(v, _mm256_loadu_si256((__m256i const*)(data + beg)));
+        auto const mask = uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+        if(mask) return beg + std::countr_zero(mask);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    int32x4_t const v = vdupq_n_s32(x);
+    for(; beg + simd_lanes <= end; beg += simd_lanes) {
+        if(vmaxvq_u32(vceqq_s32(v, vld1q_s32(data + beg)))) break;
+    }
+#endif
+    while(beg < end && data[beg] != x) ++beg;
+    return beg;
+}
+
+// the number of bytes processed at once, where AVX-512 machines use AVX2 as well
+#if defined(__AVX2__)
+constexpr size_t simd_lanes_u8 = 32;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+constexpr size_t simd_lanes_u8 = 16;
+#else
+constexpr size_t simd_lanes_u8 = 0;
+#endif
+
+// reduces the bytes data[beg..end) to their minimum (or maximum) value, requires end - beg >= simd_lanes_u8
+template<bool minimum>
+inline uint8_t simd_reduce(uint8_t const* data, size_t beg, size_t const end) {
+#if defined(__AVX2__)
+    auto const op = [](__m256i a, __m256i b){ if constexpr(minimum) return _mm256_min_epu8(a, b); else return _mm256_max_epu8(a, b); };
+    __m256i m = _mm256_loadu_si256((__m256i const*)(data + beg));
+    for(beg += simd_lanes_u8; beg + simd_lanes_u8 <= end; beg += simd_lanes_u8) {
+        m = op(m, _mm256_loadu_si256((__m256i const*)(data + beg)));
+    }
+    m = op(m, _mm256_loadu_si256((__m256i const*)(data + end - simd_lanes_u8))); // nb: overlapping tail
+
+    // horizontal reduction
+    auto const op128 = [](__m128i a, __m128i b){ if constexpr(minimum) return _mm_min_epu8(a, b); else return _mm_max_epu8(a, b); };
+    __m128i h = op128(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+    h = op128(h, _mm_srli_si128(h, 8));
+    h = op128(h, _mm_srli_si128(h, 4));
+    h = op128(h, _mm_srli_si128(h, 2));
+    h = op128(h, _mm_srli_si128(h, 1));
+    return uint8_t(_mm_cvtsi128_si32(h));
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    auto const op = [](uint8x16_t a, uint8x16_t b){ if constexpr(minimum) return vminq_u8(a, b); else return vmaxq_u8(a, b); };
+    uint8x16_t m = vld1q_u8(data + beg);
+    for(beg += simd_lanes_u8; beg + simd_lanes_u8 <= end; beg += simd_lanes_u8) {
+        m = op(m, vld1q_u8(data + beg));
+    }
+    m = op(m, vld1q_u8(data + end - simd_lanes_u8)); // nb: overlapping tail
+    if constexpr(minimum) return vminvq_u8(m); else return vmaxvq_u8(m);
+#else
+    return 0; // nb: never called
+#endif
+}
+
+// finds the first position in the bytes data[beg..end) that holds the given value, which must be contained
+inline size_t simd_find(uint8_t const* data, size_t beg, size_t const end, uint8_t const x) {
+#if defined(__AVX2__)
+    __m256i const v = _mm256_set1_epi8(char(x));
+    for(; beg + simd_lanes_u8 <= end; beg += simd_lanes_u8) {
+        auto const mask = uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_loadu_si256((__m256i const*)(data + beg)))));
+        if(mask) return beg + std::countr_zero(mask);
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    uint8x16_t const v = vdupq_n_u8(x);
+    for(; beg + simd_lanes_u8 <= end; beg += simd_lanes_u8) {
+        if(vmaxvq_u8(vceqq_u8(v, vld1q_u8(data + beg)))) break;
+    }
+#endif
+    while(beg < end && data[beg] != x) ++beg;
+    return beg;
+}
+
+}
+
+// scans data[beg..end) for the leftmost minimum (or maximum), stores it in min and returns its position
+// for 32-bit signed integers, this uses AVX-512, AVX2 or NEON if available at compile time, and for bytes, AVX2 or NEON
+// nb: there is no runtime dispatch, so on x86, the vectorized scan requires building with the instruction sets enabled, e.g., -march=native
+template<bool minimum, std::totally_ordered Value, std::unsigned_integral Index>
+inline Index min_scan(Value const* data, Index const beg, Index const end, Value& min) {
+    if constexpr(std::is_same_v<Value, int32_t> && internal::simd_lanes > 0) {
+        if(end - beg >= internal::simd_lanes) {
+            min = internal::simd_reduce<minimum>(data, beg, end);
+            return Index(internal::simd_find(data, beg, end, min));
+        }
+    } else if constexpr(std::is_same_v<Value, uint8_t> && internal::simd_lanes_u8 > 0) {
+        if(end - beg >= internal::simd_lanes_u8) {
+            min = internal::simd_reduce<minimum>(data, beg, end);
+            return Index(internal::simd_find(data, beg, end, min));
+        }
+    }
+    return min_scan_scalar<minimum>(data, beg, end, min);
+}
+
+}
+
+#endif
@@ -28,13 +28,22 @@
 #ifndef _RMQ_RMQ_HPP
 #define _RMQ_RMQ_HPP
 
+#include "min_scan.hpp"
 #include "rmq_bender_farach_colton.hpp"
+#include "rmq_stack_bitmask.hpp"
 
 #include <algorithm>
 
 namespace rmq {
 
-template<std::totally_ordered Value, size_t block_size_ = 64, std::unsigned_integral Index = uint32_t, bool minimum_ = true>
+// two-level RMQ that scans short intervals naively and answers queries over the block minima using the given engine,
+// which can be either RMQBenderFarachColton (faster) or RMQStackBitmask (less space)
+template<
+    std::totally_ordered Value,
+    size_t block_size_ = 64,
+    std::unsigned_integral Index = uint32_t,
+    bool minimum_ = true,
+    template<std::totally_ordered, std::unsigned_integral, bool> typename BlockRMQ = RMQBenderFarachColton>
 class RMQ {
 private:
     static constexpr bool leq(Value const& a, Value const& b) { return compare<minimum_>(a, b); }
@@ -43,33 +52,25 @@ private:
     Value const* data_;
     std::unique_ptr<Index[]> block_min_pos_;
     std::unique_ptr<Value[]> block_min_;
-    RMQBenderFarachColton<Value, Index, minimum_> block_rmq_;
+    BlockRMQ<Value, Index, minimum_> block_rmq_;
 
-    Index naive_rmq(Index beg, Index const end, Value& min) const {
-        Index min_pos = beg;
-        min = data_[beg];
-        
-        ++beg;
-        while(beg < end) {
-            if(lt(data_[beg], min)) {
-                min = data_[beg];
-                min_pos = beg;
-            }
-            ++beg;
-        }
-        return min_pos;
+    Index naive_rmq(Index const beg, Index const end, Value& min) const {
+        return min_scan<minimum_>(data_, beg, end, min);
     }
 
 public:
     RMQ() : data_(nullptr) {
     }
 
-    RMQ(Value const* data, size_t const n) : data_(data) {
+    // the block minima and the block RMQ are computed using the given number of threads if OpenMP is enabled
+    RMQ(Value const* data, size_t const n, int const threads = 1) : data_(data) {
+        if(n == 0) return;
         size_t const num_blocks = (n-1) / block_size_ + 1;
 
         block_min_pos_ = std::make_unique<Index[]>(num_blocks);
         block_min_ = std::make_unique<Value[]>(num_blocks);
 
+        #pragma omp parallel for num_threads(threads) if(threads > 1)
         for(size_t block = 0; block < num_blocks; block++) {
             Index const beg = block * block_size_;
             Index const end = std::min(beg + block_size_, n);
@@ -81,7 +82,7 @@ public:
             block_min_pos_[block] = min_pos;
         }
 
-        block_rmq_ = RMQBenderFarachColton<Value, Index, minimum_>(block_min_.get(), num_blocks);
+        block_rmq_ = BlockRMQ<Value, Index, minimum_>(block_min_.get(), num_blocks, threads);
     }
 
     RMQ(RMQ&&) = default;
@@ -138,9 +139,21 @@ public:
         return rmq(i, j, discard);
     }
 
+    // prefetches the part of the data that a query with the given endpoint scans, which is the endpoint's block
+    void prefetch(Index const i) const {
+        auto const* block = (char const*)(data_ + (i / block_size_) * block_size_);
+        for(size_t k = 0; k < block_size_ * sizeof(Value); k += 64) __builtin_prefetch(block + k);
+    }
+
     Index operator()(Index const i, Index const j) const {
         return rmq(i, j);
     }
+
+    // reports the space needed for the given number of entries, not counting the data
+    static size_t size_in_bytes(size_t const n) {
+        size_t const num_blocks = n > 0 ? (n-1) / block_size_ + 1 : 0;
+        return num_blocks * (sizeof(Index) + sizeof(Value)) + BlockRMQ<Value, Index, minimum_>::size_in_bytes(num_blocks);
+    }
 };
 
 }
@@ -53,12 +53,15 @@ public:
     RMQBenderFarachColton() : data_(nullptr) {
     }
 
-    RMQBenderFarachColton(Value const* data, size_t const n) : data_(data) {
-        size_t const num_levels = std::bit_width(n) - 1;
+    // the levels are built using the given number of threads if OpenMP is enabled
+    RMQBenderFarachColton(Value const* data, size_t const n, int const threads = 1) : data_(data) {
+        size_t const num_levels = n > 0 ? std::bit_width(n) - 1 : 0;
         rmq_ = std::make_unique<Level[]>(num_levels);
+        if(num_levels == 0) return; // nb: there are no non-trivial intervals
 
         // build first level
         rmq_[0] = std::make_unique<Index[]>(n-1);
+        #pragma omp parallel for num_threads(threads) if(threads > 1)
         for(Index i = 0; i < n-1; i++) {
             rmq_[0][i] = leq(data[i], data[i+1]) ? i : i+1;
         }
@@ -69,6 +72,7 @@ public:
             rmq_[level] = std::make_unique<Index[]>(level_size);
 
             size_t const interval_size = 1ULL << level;
+            #pragma omp parallel for num_threads(threads) if(threads > 1)
             for(Index i = 0; i < level_size; i++) {
                 auto const a = rmq_[level-1][i];
                 auto const b = rmq_[level-1][i+interval_size];
@@ -99,6 +103,14 @@ public:
     size_t operator()(size_t const i, size_t const j) const {
         return rmq(i, j);
     }
+
+    // reports the space needed for the given number of entries, not counting the data
+    static size_t size_in_bytes(size_t const n) {
+        size_t const num_levels = n > 0 ? std::bit_width(n) - 1 : 0;
+        size_t size = num_levels * sizeof(Level);
+        for(size_t level = 0; level < num_levels; level++) size += (n - ((2ULL << level) - 1)) * sizeof(Index);
+        return size;
+    }
 };
 
 }
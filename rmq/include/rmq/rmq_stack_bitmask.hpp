@@ -0,0 +1,154 @@
+/**
+ * rmq/rmq_stack_bitmask.hpp
+ * part of pdinklag/lzend
+ *
+ * MIT License
+ *
+ * Copyright (c) Patrick Dinklage
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _RMQ_RMQ_STACK_BITMASK_HPP
+#define _RMQ_RMQ_STACK_BITMASK_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "compare.hpp"
+#include "rmq_bender_farach_colton.hpp"
+
+namespace rmq {
+
+// RMQ with constant query time that uses 64 bits per entry plus a sparse table over every 64th entry
+//
+// the data is divided into superblocks of 64 entries; for each position j, a bitmask tells which positions of its superblock
+// are on the stack of left-to-right minima after processing position j, so in-superblock queries are answered by a single bit scan
+// compared to RMQBenderFarachColton, which stores log(n) full index arrays, this needs significantly less space for large n
+template<std::totally_ordered Value, std::unsigned_integral Index = uint32_t, bool minimum_ = true>
+class RMQStackBitmask {
+private:
+    static constexpr bool leq(Value const& a, Value const& b) { return compare<minimum_>(a, b); }
+    static constexpr bool lt(Value const& a, Value const& b) { return compare_strict<minimum_>(a, b); }
+
+    static constexpr size_t superblock_size_ = 64;
+
+    Value const* data_;
+    std::unique_ptr<uint64_t[]> masks_;
+    std::unique_ptr<Index[]> superblock_min_pos_;
+    std::unique_ptr<Value[]> superblock_min_;
+    RMQBenderFarachColton<Value, Index, minimum_> superblock_rmq_;
+
+    size_t in_superblock_rmq(size_t const i, size_t const j) const {
+        assert(i / superblock_size_ == j / superblock_size_);
+        auto const mask = masks_[j] & (UINT64_MAX << (i % superblock_size_));
+        return (j / superblock_size_) * superblock_size_ + std::countr_zero(mask);
+    }
+
+public:
+    RMQStackBitmask() : data_(nullptr) {
+    }
+
+    // the bitmasks and the sparse table are built using the given number of threads if OpenMP is enabled
+    RMQStackBitmask(Value const* data, size_t const n, int const threads = 1) : data_(data) {
+        if(n == 0) return;
+        size_t const num_superblocks = (n-1) / superblock_size_ + 1;
+
+        masks_ = std::make_unique<uint64_t[]>(n);
+        superblock_min_pos_ = std::make_unique<Index[]>(num_superblocks);
+        superblock_min_ = std::make_unique<Value[]>(num_superblocks);
+
+        #pragma omp parallel for num_threads(threads) if(threads > 1)
+        for(size_t sb = 0; sb < num_superblocks; sb++) {
+            size_t const beg = sb * superblock_size_;
+            size_t const end = std::min(beg + superblock_size_, n);
+
+            // simulate the stack of minima, keeping equal values so the leftmost minimum survives
+            uint8_t stack[superblock_size_];
+            size_t top = 0;
+            uint64_t mask = 0;
+            for(size_t j = beg; j < end; j++) {
+                while(top > 0 && !leq(data[beg + stack[top-1]], data[j])) {
+                    mask &= ~(1ULL << stack[--top]);
+                }
+                stack[top++] = j - beg;
+                mask |= 1ULL << (j - beg);
+                masks_[j] = mask;
+            }
+
+            // the bottom of the stack is the superblock's minimum
+            superblock_min_pos_[sb] = beg + stack[0];
+            superblock_min_[sb] = data[beg + stack[0]];
+        }
+
+        superblock_rmq_ = RMQBenderFarachColton<Value, Index, minimum_>(superblock_min_.get(), num_superblocks, threads);
+    }
+
+    RMQStackBitmask(RMQStackBitmask&&) = default;
+    RMQStackBitmask& operator=(RMQStackBitmask&&) = default;
+
+    RMQStackBitmask(RMQStackBitmask const&) = delete;
+    RMQStackBitmask& operator=(RMQStackBitmask const&) = delete;
+
+    size_t rmq(size_t const i, size_t const j) const {
+        assert(i <= j);
+        if(i == j)[[unlikely]] return i;
+
+        size_t const sb_i = i / superblock_size_;
+        size_t const sb_j = j / superblock_size_;
+        if(sb_i == sb_j) return in_superblock_rmq(i, j);
+
+        // combine the suffix of i's superblock, the superblocks in between and the prefix of j's superblock, preferring the leftmost
+        size_t min_pos = in_superblock_rmq(i, sb_i * superblock_size_ + superblock_size_ - 1);
+        if(sb_i + 1 < sb_j) {
+            size_t const mid_min_pos = superblock_min_pos_[superblock_rmq_(sb_i + 1, sb_j - 1)];
+            if(lt(data_[mid_min_pos], data_[min_pos])) min_pos = mid_min_pos;
+        }
+
+        size_t const right_min_pos = in_superblock_rmq(sb_j * superblock_size_, j);
+        if(lt(data_[right_min_pos], data_[min_pos])) min_pos = right_min_pos;
+        return min_pos;
+    }
+
+    // prefetches the bitmask and the data that a query with the given endpoint accesses first
+    void prefetch(size_t const i) const {
+        __builtin_prefetch(masks_.get() + i);
+        __builtin_prefetch(data_ + i);
+    }
+
+    size_t operator()(size_t const i, size_t const j) const {
+        return rmq(i, j);
+    }
+
+    // reports the space needed for the given number of entries, not counting the data
+    static size_t size_in_bytes(size_t const n) {
+        size_t const num_superblocks = n > 0 ? (n-1) / superblock_size_ + 1 : 0;
+        return n * sizeof(uint64_t) + num_superblocks * (sizeof(Index) + sizeof(Value))
+            + RMQBenderFarachColton<Value, Index, minimum_>::size_in_bytes(num_superblocks);
+    }
+};
+
+}
+
+#endif
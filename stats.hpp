@@ -0,0 +1,251 @@
+/**
+ * stats.hpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _LZEND_STATS_HPP
+#define _LZEND_STATS_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+#include <sys/resource.h>
+
+#if __has_include(<linux/perf_event.h>)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define LZEND_PERF_EVENTS
+#endif
+
+namespace lzend {
+
+// reports the peak resident set size of this process in bytes
+inline size_t peak_memory() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return size_t(usage.ru_maxrss) * 1024; // nb: Linux reports kilobytes
+}
+
+// counts the last-level cache misses of the calling thread using perf_event_open, excluding threads it spawns
+// if hardware performance counters are not available, e.g., in virtual machines or due to kernel.perf_event_paranoid, the counter is not good
+class CacheMissCounter {
+private:
+    int fd_;
+
+public:
+    // opens the counter if enabled
+    CacheMissCounter(bool const enable = true) : fd_(-1) {
+#ifdef LZEND_PERF_EVENTS
+        if(!enable) return;
+
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+
+    ~CacheMissCounter() {
+#ifdef LZEND_PERF_EVENTS
+        if(fd_ >= 0) close(fd_);
+#endif
+    }
+
+    CacheMissCounter(CacheMissCounter const&) = delete;
+    CacheMissCounter& operator=(CacheMissCounter const&) = delete;
+
+    // tells whether the counter is available
+    bool good() const { return fd_ >= 0; }
+
+    // the number of cache misses since the counter was opened, or zero if it is not available
+    uint64_t read() const {
+        uint64_t count = 0;
+#ifdef LZEND_PERF_EVENTS
+        if(fd_ >= 0 && ::read(fd_, &count, sizeof(count)) != ssize_t(sizeof(count))) count = 0;
+#endif
+        return count;
+    }
+};
+
+// the phases of the parsing process in order, followed by the time spent storing or loading checkpointed arrays
+enum class Phase : size_t { sa, lcp, rmq, isa, parse, repair, checkpoint };
+
+constexpr size_t num_phases = 7;
+
+// the name of a phase as used for reporting
+constexpr char const* phase_name(Phase const phase) {
+    constexpr char const* names[] = { "sa", "lcp", "rmq", "isa", "parse", "repair", "checkpoint" };
+    return names[size_t(phase)];
+}
+
+// statistics policy that collects nothing
+//
+// a statistics policy receives events from lzend::parse via the member functions below; since the events of the parsing loop are
+// forwarded to empty inline functions and guarded by the enabled flag, this policy causes no overhead whatsoever
+// when parsing in chunks, each chunk collects its statistics into a default-constructed policy object, which is then accumulated
+struct NoStats {
+    static constexpr bool enabled = false;
+
+    void on_phase(Phase, std::chrono::steady_clock::duration) {}
+    void on_cache_misses(Phase, uint64_t) {}
+    void on_merge() {}
+    void on_extend() {}
+    void on_new_phrase() {}
+    void on_predecessor_query() {}
+    void on_successor_query() {}
+    void on_rmq_query(size_t, size_t) {}
+    void on_capped_rmq_query() {}
+    void on_skipped_requery() {}
+    void on_capped_phrase() {}
+    void on_repair(size_t) {}
+    void accumulate(NoStats const&) {}
+};
+
+// statistics policy that collects per-phase timings and memory as well as event counts of the parsing loop
+struct Stats {
+    static constexpr bool enabled = true;
+
+    std::chrono::steady_clock::duration phase_time[num_phases] = {}; // wall time per phase
+    size_t phase_peak_memory[num_phases] = {}; // peak resident set size of the process at the end of each phase in bytes
+    uint64_t phase_cache_misses[num_phases] = {}; // last-level cache misses of the parsing thread per phase, if available
+    bool cache_misses_available = false;
+
+    size_t num_merges = 0; // case 1: the last two phrases were merged
+    size_t num_extensions = 0; // case 2: the last phrase was extended
+    size_t num_new_phrases = 0; // case 3: a new phrase was started
+    size_t num_repaired = 0; // phrases absorbed when repairing chunk boundaries
+
+    size_t num_predecessor_queries = 0;
+    size_t num_successor_queries = 0;
+    size_t num_rmq_queries = 0;
+    size_t total_rmq_interval = 0; // sum of the lengths of all RMQ intervals
+
+    // the number of times each limit of the bounded-latency parsing applied (see lzend::Options)
+    size_t num_capped_rmq_queries = 0; // RMQs not performed because the interval was too long
+    size_t num_skipped_requeries = 0; // merges not considered because a candidate would have to be queried again
+    size_t num_capped_phrases = 0; // positions at which a phrase was not merged or extended because it would have become too long
+
+    void on_phase(Phase const phase, std::chrono::steady_clock::duration const t) {
+        phase_time[size_t(phase)] += t;
+        phase_peak_memory[size_t(phase)] = std::max(phase_peak_memory[size_t(phase)], lzend::peak_memory());
+    }
+
+    void on_cache_misses(Phase const phase, uint64_t const num_misses) {
+        phase_cache_misses[size_t(phase)] += num_misses;
+        cache_misses_available = true;
+    }
+
+    void on_merge() { ++num_merges; }
+    void on_extend() { ++num_extensions; }
+    void on_new_phrase() { ++num_new_phrases; }
+    void on_predecessor_query() { ++num_predecessor_queries; }
+    void on_successor_query() { ++num_successor_queries; }
+
+    void on_rmq_query(size_t const i, size_t const j) {
+        ++num_rmq_queries;
+        total_rmq_interval += j - i + 1;
+    }
+
+    void on_capped_rmq_query() { ++num_capped_rmq_queries; }
+    void on_skipped_requery() { ++num_skipped_requeries; }
+    void on_capped_phrase() { ++num_capped_phrases; }
+
+    void on_repair(size_t const num_merged) { num_repaired += num_merged; }
+
+    void accumulate(Stats const& other) {
+        for(size_t p = 0; p < num_phases; p++) {
+            phase_time[p] += other.phase_time[p];
+            phase_peak_memory[p] = std::max(phase_peak_memory[p], other.phase_peak_memory[p]);
+            phase_cache_misses[p] += other.phase_cache_misses[p];
+        }
+        cache_misses_available = cache_misses_available || other.cache_misses_available;
+        num_merges += other.num_merges;
+        num_extensions += other.num_extensions;
+        num_new_phrases += other.num_new_phrases;
+        num_repaired += other.num_repaired;
+        num_predecessor_queries += other.num_predecessor_queries;
+        num_successor_queries += other.num_successor_queries;
+        num_rmq_queries += other.num_rmq_queries;
+        total_rmq_interval += other.total_rmq_interval;
+        num_capped_rmq_queries += other.num_capped_rmq_queries;
+        num_skipped_requeries += other.num_skipped_requeries;
+        num_capped_phrases += other.num_capped_phrases;
+    }
+
+    // the total wall time of all phases
+    std::chrono::steady_clock::duration total_time() const {
+        std::chrono::steady_clock::duration t = {};
+        for(auto const x : phase_time) t += x;
+        return t;
+    }
+
+    // the peak resident set size at the end of any phase
+    size_t peak_memory() const {
+        return *std::max_element(phase_peak_memory, phase_peak_memory + num_phases);
+    }
+
+    double avg_rmq_interval() const {
+        return num_rmq_queries > 0 ? double(total_rmq_interval) / num_rmq_queries : 0.0;
+    }
+
+    // writes the statistics as a JSON object, with times in milliseconds and memory in bytes
+    void print_json(std::ostream& out) const {
+        auto const ms = [](std::chrono::steady_clock::duration const t){ return std::chrono::duration<double, std::milli>(t).count(); };
+        out << "{\"phases\":{";
+        for(size_t p = 0; p < num_phases; p++) {
+            if(p > 0) out << ",";
+            out << "\"" << phase_name(Phase(p)) << "\":{\"time_ms\":" << ms(phase_time[p]) << ",\"peak_memory\":" << phase_peak_memory[p];
+            if(cache_misses_available) out << ",\"cache_misses\":" << phase_cache_misses[p];
+            out << "}";
+        }
+        out << "},\"total_time_ms\":" << ms(total_time())
+            << ",\"peak_memory\":" << peak_memory()
+            << ",\"merges\":" << num_merges
+            << ",\"extensions\":" << num_extensions
+            << ",\"new_phrases\":" << num_new_phrases
+            << ",\"repaired\":" << num_repaired
+            << ",\"predecessor_queries\":" << num_predecessor_queries
+            << ",\"successor_queries\":" << num_successor_queries
+            << ",\"rmq_queries\":" << num_rmq_queries
+            << ",\"avg_rmq_interval\":" << avg_rmq_interval()
+            << ",\"capped_rmq_queries\":" << num_capped_rmq_queries
+            << ",\"skipped_requeries\":" << num_skipped_requeries
+            << ",\"capped_phrases\":" << num_capped_phrases
+            << "}";
+    }
+};
+
+}
+
+#endif
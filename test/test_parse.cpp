@@ -0,0 +1,643 @@
+/**
+ * test_parse.cpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "access_index.hpp"
+#include "compact_lcp.hpp"
+#include "decompress.hpp"
+#include "encoding.hpp"
+#include "lzend.hpp"
+#include "reference.hpp"
+
+namespace lzend::test {
+
+// generates a text of the given length over the first sigma letters
+std::string random_text(size_t const n, size_t const sigma, uint32_t const seed) {
+    std::mt19937 gen(seed);
+    std::string s(n, 0);
+    for(auto& c : s) c = char('a' + gen() % sigma);
+    return s;
+}
+
+// generates the prefix of the given length of the infinite Fibonacci word
+std::string fibonacci(size_t const n) {
+    std::string a = "a", b = "ab";
+    while(b.length() < n) {
+        a = std::exchange(b, b + a);
+    }
+    return b.substr(0, n);
+}
+
+// generates a repetitive text consisting of copies of a random text with a few mutations each
+std::string repetitive(size_t const n, uint32_t const seed) {
+    std::mt19937 gen(seed);
+    auto const base = random_text(n / 16 + 1, 26, seed);
+    std::string s;
+    while(s.length() < n) {
+        auto copy = base;
+        for(size_t k = 0; k < 4; k++) copy[gen() % copy.length()] = char('A' + gen() % 26);
+        s += copy;
+    }
+    return s.substr(0, n);
+}
+
+// decompresses a parsing of integer symbols symbol by symbol
+template<typename Symbol>
+std::vector<Symbol> decompress_symbols(std::vector<Phrase<int32_t, Symbol>> const& parsing) {
+    std::vector<Symbol> out;
+    std::vector<size_t> ends;
+    for(auto const& f : parsing) {
+        if(f.len > 1) {
+            REQUIRE(size_t(f.lnk) < ends.size());
+            size_t const src_end = ends[f.lnk] + 1;
+            REQUIRE(src_end >= size_t(f.len - 1));
+            for(size_t k = src_end - (f.len - 1); k < src_end; k++) out.push_back(out[k]);
+        }
+        out.push_back(f.ext);
+        ends.push_back(out.size() - 1);
+    }
+    return out;
+}
+
+// maps a text to integer symbols, spreading the characters over the given range
+template<typename Symbol>
+std::vector<Symbol> to_symbols(std::string const& s, uint64_t const spread) {
+    std::vector<Symbol> v(s.length());
+    for(size_t i = 0; i < s.length(); i++) v[i] = Symbol(uint64_t(uint8_t(s[i])) * spread);
+    return v;
+}
+
+// tells whether two parsings consist of the same phrases
+template<typename Index>
+bool same_parsing(std::vector<Phrase<Index>> const& a, std::vector<Phrase<Index>> const& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](auto const& f, auto const& g){ return f.lnk == g.lnk && f.len == g.len && f.ext == g.ext; });
+}
+
+// the pairs of references and inputs parsed against them, including similar versions of a text and texts containing zero bytes
+std::vector<std::pair<std::string, std::string>> reference_inputs() {
+    auto const base = random_text(5000, 26, 5);
+    auto version = base;
+    std::mt19937 gen(6);
+    for(size_t k = 0; k < 16; k++) version[gen() % version.length()] = char('A' + gen() % 26);
+
+    auto zeros = random_text(3000, 4, 7);
+    for(auto& c : zeros) c -= 'a';
+
+    return {
+        { "a", "" }, { "a", "aaaa" }, { "abcab", "cabca" }, { base, base }, { base, version }, { version, base.substr(1000, 2000) },
+        { fibonacci(1000), fibonacci(2000) }, { repetitive(20000, 8), repetitive(20000, 8).substr(5000) }, { repetitive(20000, 9), random_text(5000, 26, 10) },
+        { zeros, random_text(3000, 4, 11) }, { zeros, zeros.substr(100) + zeros.substr(0, 100) } };
+}
+
+std::vector<std::string> inputs() {
+    return { "", "a", "aaaaaaaa", "abcabcabcabd", fibonacci(1000), random_text(5000, 2, 1), random_text(5000, 26, 2), repetitive(20000, 3) };
+}
+
+TEST_SUITE("lzend") {
+    TEST_CASE("parse and decompress") {
+        for(auto const& s : inputs()) {
+            auto const parsing = parse(s);
+            CHECK(decompress(parsing) == s);
+        }
+    }
+
+    TEST_CASE("encode and decode") {
+        for(auto const& s : inputs()) {
+            auto const parsing = parse(s);
+            std::stringstream buf;
+            encode(buf, parsing);
+            auto const decoded = decode(buf);
+            REQUIRE(decoded.size() == parsing.size());
+            CHECK(decompress(decoded) == s);
+        }
+    }
+
+    TEST_CASE("decode malformed input") {
+        auto const parsing = parse(repetitive(20000, 4));
+        std::ostringstream out;
+        encode(out, parsing);
+        auto const valid = out.str();
+        auto const decode_str = [](std::string const& str) {
+            std::istringstream in(str);
+            return decode(in);
+        };
+        REQUIRE(decode_str(valid).size() == parsing.size());
+
+        // truncated input
+        CHECK(decode_str(valid.substr(0, valid.length() / 2)).empty());
+
+        // a block whose lengths exceed the input
+        std::string huge(internal::encoding_magic, sizeof(internal::encoding_magic));
+        internal::put_varint(huge, 1);
+        internal::put_varint(huge, uint64_t(1) << 60);
+        huge += "ab";
+        CHECK(decode_str(huge).empty());
+
+        // a block whose code stream is not fully consumed by its phrases
+        std::string leftover(internal::encoding_magic, sizeof(internal::encoding_magic));
+        internal::put_varint(leftover, 1);
+        internal::put_varint(leftover, 2);
+        leftover += std::string("\0\0", 2) + "a";
+        internal::put_varint(leftover, 0);
+        internal::put_varint(leftover, 0);
+        CHECK(decode_str(leftover).empty());
+    }
+
+    TEST_CASE("parse in chunks with universe-based predecessor structures") {
+        using RMQ = rmq::RMQ<int32_t, 64, uint32_t>;
+        for(auto const& s : inputs()) {
+            for(size_t const max_rmq_interval : { size_t(0), size_t(64) }) {
+                Options options;
+                options.num_chunks = 4;
+                options.max_rmq_interval = max_rmq_interval;
+                auto const expected = parse(s, options);
+                auto const range_marking = parse<int32_t, RMQ, ordered::range_marking::Map<uint32_t, int32_t>>(s, options);
+                auto const bit_trie = parse<int32_t, RMQ, ordered::bit_trie::Map<uint32_t, int32_t>>(s, options);
+                REQUIRE(range_marking.size() == expected.size());
+                REQUIRE(bit_trie.size() == expected.size());
+                for(size_t j = 0; j < expected.size(); j++) {
+                    CHECK(range_marking[j].lnk == expected[j].lnk);
+                    CHECK(range_marking[j].len == expected[j].len);
+                    CHECK(bit_trie[j].lnk == expected[j].lnk);
+                    CHECK(bit_trie[j].len == expected[j].len);
+                }
+                CHECK(decompress(bit_trie) == s);
+            }
+        }
+    }
+
+    TEST_CASE_TEMPLATE("parse integer symbols", Symbol, uint16_t, uint32_t) {
+        for(auto const& s : inputs()) {
+            // symbols below 256 yield the same parsing as the text
+            auto const expected = parse(s);
+            auto const small = to_symbols<Symbol>(s, 1);
+            auto const parsing = parse(std::span<Symbol const>(small));
+            REQUIRE(parsing.size() == expected.size());
+            for(size_t j = 0; j < expected.size(); j++) {
+                CHECK(parsing[j].lnk == expected[j].lnk);
+                CHECK(parsing[j].len == expected[j].len);
+                CHECK(parsing[j].ext == Symbol(uint8_t(expected[j].ext)));
+            }
+            CHECK(decompress_symbols(parsing) == small);
+
+            // symbols of 256 and beyond, spread over the symbol type's range, which is larger than the input length
+            auto const large = to_symbols<Symbol>(s, uint64_t(std::numeric_limits<Symbol>::max()) / 255);
+            auto const parsing_large = parse(std::span<Symbol const>(large));
+            CHECK(parsing_large.size() == expected.size());
+            CHECK(decompress_symbols(parsing_large) == large);
+        }
+
+        // an alphabet larger than a byte
+        std::mt19937 gen(5);
+        std::vector<Symbol> v(10000);
+        for(auto& x : v) x = Symbol(gen() % 1000);
+        for(size_t i = 5000; i < v.size(); i++) v[i] = v[i - 4321];
+        CHECK(decompress_symbols(parse(std::span<Symbol const>(v))) == v);
+    }
+
+    TEST_CASE("parse with 64-bit indices") {
+        // nb: without libsais64, this runs libsais on the halves of the 64-bit arrays
+        for(auto const& s : inputs()) {
+            auto const parsing32 = parse<int32_t>(s);
+            auto const parsing64 = parse<int64_t>(s);
+            REQUIRE(parsing64.size() == parsing32.size());
+            for(size_t j = 0; j < parsing32.size(); j++) {
+                CHECK(parsing64[j].lnk == parsing32[j].lnk);
+                CHECK(parsing64[j].len == parsing32[j].len);
+                CHECK(parsing64[j].ext == parsing32[j].ext);
+            }
+            CHECK(decompress(parsing64) == s);
+
+            Options options;
+            options.low_memory = true;
+            CHECK(parse<int64_t>(s, options).size() == parsing32.size());
+            options = Options();
+            options.num_chunks = 4;
+            CHECK(decompress(parse<int64_t>(s, options)) == s);
+        }
+    }
+
+    TEST_CASE("parse against the last phrase of a reference") {
+        // the best source is the reference's last phrase, whose phrase number relative to the input is -1
+        auto const ref1 = Reference::compute("xyzw");
+        auto const parsing1 = parse("qwb", ref1);
+        CHECK(parsing1.size() == 2);
+        CHECK(decompress(parsing1, ref1) == "qwb");
+
+        auto const ref2 = Reference::compute("abcab");
+        auto const parsing2 = parse("qabq", ref2);
+        CHECK(parsing2.size() == 2);
+        CHECK(decompress(parsing2, ref2) == "qabq");
+    }
+
+    TEST_CASE("parse and decompress against a reference") {
+        for(auto const& [r, s] : reference_inputs()) {
+            auto const ref = Reference::compute(r);
+            REQUIRE(ref.good());
+            REQUIRE(ref.text() == r);
+            auto const parsing = parse(s, ref);
+            CHECK(decompress(parsing, ref) == s);
+            CHECK(parsing.size() <= parse(s).size());
+        }
+
+        // an input equal to the reference copies from it
+        auto const s = random_text(5000, 26, 12);
+        auto const ref = Reference::compute(s);
+        CHECK(parse(s, ref).size() < parse(s).size() / 10);
+    }
+
+    TEST_CASE("save and load a reference") {
+        auto const path = (std::filesystem::temp_directory_path() / "lzend_test_reference").string();
+        for(auto const& [r, s] : reference_inputs()) {
+            auto const ref = Reference::compute(r);
+            REQUIRE(ref.save(path));
+
+            Reference const loaded(path);
+            REQUIRE(loaded.good());
+            CHECK(loaded.text() == r);
+            CHECK(std::equal(loaded.ends().begin(), loaded.ends().end(), ref.ends().begin(), ref.ends().end()));
+
+            auto const parsing = parse(s, loaded);
+            CHECK(same_parsing(parsing, parse(s, ref)));
+            CHECK(decompress(parsing, loaded) == s);
+        }
+
+        // the empty reference
+        REQUIRE(Reference().save(path));
+        Reference const empty(path);
+        REQUIRE(empty.good());
+        CHECK(empty.size() == 0);
+        CHECK(same_parsing(parse("abcabc", empty), parse("abcabc")));
+
+        // truncated and corrupted files are rejected
+        auto const ref = Reference::compute(repetitive(20000, 13));
+        REQUIRE(ref.save(path));
+        auto const size = std::filesystem::file_size(path);
+        std::filesystem::resize_file(path, size - 1);
+        CHECK(!Reference(path).good());
+
+        REQUIRE(ref.save(path));
+        {
+            std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(0);
+            f.put('X');
+        }
+        CHECK(!Reference(path).good());
+
+        REQUIRE(ref.save(path));
+        {
+            // nb: a psi entry beyond the reference's length
+            std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(internal::ReferenceLayout(ref.size(), ref.num_phrases()).psi);
+            int32_t const bad = INT32_MAX;
+            f.write((char const*)&bad, sizeof(bad));
+        }
+        CHECK(!Reference(path).good());
+
+        std::filesystem::remove(path);
+        CHECK(!Reference(path).good());
+    }
+
+    TEST_CASE("interrupt and resume a parse from a checkpoint") {
+        auto const dir = std::filesystem::temp_directory_path() / "lzend_test_checkpoint";
+        std::filesystem::remove_all(dir);
+        auto const s = repetitive(20000, 14);
+        auto const expected = parse(s);
+
+        Options options;
+        options.checkpoint_dir = dir.string();
+        options.checkpoint_interval = 997;
+
+        // nb: with checkpointing, the phrases are passed to the sink only at the end, after the last snapshot has been taken
+        auto interrupt = [&](std::string const& t){
+            size_t k = 0;
+            CHECK_THROWS_AS(parse(t, [&](Phrase<int32_t> const&){ if(++k == 10) throw std::runtime_error("interrupted"); }, options), std::runtime_error);
+            REQUIRE(std::filesystem::exists(dir / "state"));
+        };
+        auto resume = [&](std::string const& t){
+            std::vector<Phrase<int32_t>> parsing;
+            parse(t, [&](Phrase<int32_t> const& f){ parsing.push_back(f); }, options);
+            return parsing;
+        };
+
+        interrupt(s);
+        CHECK(same_parsing(resume(s), expected));
+        for(auto const name : { "lcp", "isa", "state", "parsing" }) CHECK(!std::filesystem::exists(dir / name));
+
+        // a checkpoint of a different input of the same length is ignored
+        auto const t = repetitive(20000, 15);
+        interrupt(t);
+        CHECK(same_parsing(resume(s), expected));
+
+        // a snapshot whose position does not match its phrases is ignored
+        interrupt(s);
+        {
+            std::fstream f(dir / "state", std::ios::in | std::ios::out | std::ios::binary);
+            f.seekg(offsetof(internal::CheckpointHeader, pos));
+            uint64_t pos;
+            f.read((char*)&pos, sizeof(pos));
+            pos -= 1;
+            f.seekp(offsetof(internal::CheckpointHeader, pos));
+            f.write((char const*)&pos, sizeof(pos));
+        }
+        CHECK(same_parsing(resume(s), expected));
+
+        interrupt(s);
+        {
+            std::fstream f(dir / "state", std::ios::in | std::ios::out | std::ios::binary);
+            uint64_t const pos = s.length() + 1;
+            f.seekp(offsetof(internal::CheckpointHeader, pos));
+            f.write((char const*)&pos, sizeof(pos));
+        }
+        CHECK(same_parsing(resume(s), expected));
+
+        std::filesystem::remove_all(dir);
+    }
+
+    TEST_CASE("permute the ISA and parse with the pipeline") {
+        // nb: the first round scatters n/16 positions directly, and the blocks of the partitioning rounds span 64 Ki positions
+        for(size_t const n : { 1, 2, 15, 16, 17, 31, 32, 33, 47, 48, 49, 1000, 4097, 65535, 65536, 65537, 100003 }) {
+            std::vector<int32_t> sa(n);
+            std::iota(sa.begin(), sa.end(), 0);
+            std::shuffle(sa.begin(), sa.end(), std::mt19937(n));
+            std::vector<int32_t> expected(n);
+            for(size_t i = 0; i < n; i++) expected[n - sa[i] - 1] = i;
+
+            for(int const threads : { 1, 2 }) {
+                auto buf = sa;
+                std::vector<int32_t> isa(n);
+                internal::permute_isa(buf.data(), isa.data(), int32_t(n), threads);
+                CHECK(isa == expected);
+            }
+
+            auto const s = random_text(n, 4, n);
+            for(int const threads : { 1, 2, 3 }) {
+                Options options;
+                options.pipeline = true;
+                options.threads = threads;
+                auto const parsing = parse(s, options);
+                CHECK(same_parsing(parsing, parse(s)));
+                CHECK(decompress(parsing) == s);
+            }
+        }
+    }
+
+    TEST_CASE("compact LCP array") {
+        // random values with runs of exceptions, some of which span several 64-bit words and whole RMQ blocks
+        for(size_t const n : { 1, 2, 64, 65, 300, 5000 }) {
+            std::mt19937 gen(n);
+            std::vector<int32_t> lcp(n);
+            for(size_t i = 0; i < n;) {
+                if(gen() % 4 == 0) {
+                    size_t const run = std::min(size_t(1 + gen() % 500), n - i);
+                    for(size_t k = 0; k < run; k++) lcp[i++] = 255 + gen() % 1000;
+                } else {
+                    lcp[i++] = gen() % 300;
+                }
+            }
+
+            CompactLCP<int32_t> const compact(lcp.data(), n);
+            CHECK(compact.num_exceptions() == CompactLCP<int32_t>::count_exceptions(lcp.data(), n));
+            CHECK(compact.max() == *std::max_element(lcp.begin(), lcp.end()));
+            for(size_t i = 0; i < n; i++) CHECK(compact[i] == lcp[i]);
+
+            auto check = [&](size_t const i, size_t const j){
+                REQUIRE(compact.min(i, j) == *std::min_element(lcp.begin() + i, lcp.begin() + j + 1));
+            };
+            if(n <= 300) {
+                for(size_t i = 0; i < n; i++) {
+                    for(size_t j = i; j < n; j++) check(i, j);
+                }
+            } else {
+                for(size_t q = 0; q < 100000; q++) {
+                    size_t const i = gen() % n;
+                    check(i, i + gen() % (n - i));
+                }
+            }
+        }
+    }
+
+    TEST_CASE("parse with a compact LCP array") {
+        // inputs whose long repeats yield LCP values of 255 and beyond
+        auto with_repeats = [](size_t const n, size_t const len, uint32_t const seed){
+            std::mt19937 gen(seed);
+            auto s = random_text(n, 26, seed);
+            for(size_t k = 0; k < 4; k++) {
+                size_t const src = gen() % (s.length() - len);
+                s.insert(gen() % s.length(), s.substr(src, len));
+            }
+            return s;
+        };
+
+        auto test_inputs = inputs();
+        test_inputs.push_back(with_repeats(20000, 300, 16));
+        test_inputs.push_back(with_repeats(20000, 2000, 17));
+        test_inputs.push_back(random_text(20000, 26, 18) + std::string(1000, 'a'));
+        for(auto const& s : test_inputs) {
+            for(int const threads : { 1, 2 }) {
+                Options options;
+                options.compact_lcp = true;
+                options.threads = threads;
+                auto const parsing = parse(s, options);
+                CHECK(same_parsing(parsing, parse(s)));
+                CHECK(decompress(parsing) == s);
+
+                options.num_chunks = 4;
+                auto const chunked = parse(s, options);
+                options.compact_lcp = false;
+                CHECK(same_parsing(chunked, parse(s, options)));
+            }
+        }
+    }
+
+    TEST_CASE_TEMPLATE("reuse a parser", Marked, ordered::btree::Map<int32_t, int32_t>, ordered::range_marking::Map<uint32_t, int32_t>) {
+        using RMQ = rmq::RMQ<int32_t, 64, uint32_t>;
+
+        // documents that grow and then shrink, so stale state of a longer document would show in a shorter one
+        std::vector<std::string> const docs = {
+            "abcabcabcabd", fibonacci(1000), repetitive(20000, 19), random_text(5000, 2, 20), "", "aaaaaaaa", repetitive(30000, 21), "a", random_text(3000, 26, 22) };
+
+        Options variants[4];
+        variants[1].low_memory = true;
+        variants[2].compact_lcp = true;
+        variants[3].num_chunks = 3;
+        for(auto const& options : variants) {
+            Parser<int32_t, RMQ, Marked> parser(options);
+            for(int round = 0; round < 2; round++) {
+                for(auto const& s : docs) {
+                    auto const parsing = parser.parse(s);
+                    CHECK(same_parsing(parsing, parse<int32_t, RMQ, Marked>(s, options)));
+                    CHECK(decompress(parsing) == s);
+                }
+                parser.release();
+            }
+        }
+    }
+
+    TEST_CASE("parse a batch of documents") {
+        std::vector<std::string> docs;
+        for(uint32_t k = 0; k < 20; k++) docs.push_back(k % 5 == 0 ? std::string() : repetitive(1000 + 997 * k, 23 + k));
+        std::vector<std::string_view> const views(docs.begin(), docs.end());
+
+        for(int const threads : { 1, 3 }) {
+            Options options;
+            options.threads = threads;
+            auto const parsings = parse_batch(std::span<std::string_view const>(views), options);
+            REQUIRE(parsings.size() == docs.size());
+            for(size_t d = 0; d < docs.size(); d++) {
+                CHECK(same_parsing(parsings[d], parse(docs[d])));
+                CHECK(decompress(parsings[d]) == docs[d]);
+            }
+        }
+    }
+
+    TEST_CASE("random access") {
+        for(auto const& s : inputs()) {
+            AccessIndex<int32_t> const index(parse(s));
+            REQUIRE(index.length() == s.length());
+            for(size_t i = 0; i < s.length(); i++) REQUIRE(index.char_at(i) == s[i]);
+
+            std::mt19937 gen(s.length());
+            for(size_t q = 0; q < 100 && !s.empty(); q++) {
+                size_t const pos = gen() % s.length();
+                size_t const len = gen() % (s.length() - pos + 1);
+                CHECK(index.extract(pos, len) == s.substr(pos, len));
+            }
+        }
+    }
+
+    TEST_CASE("extract a batch of ranges") {
+        for(auto const& s : inputs()) {
+            if(s.empty()) continue;
+            AccessIndex<int32_t> const index(parse(s));
+            size_t const n = s.length();
+
+            // random ranges, along with zero-length, overlapping, adjacent and duplicate ones
+            std::mt19937 gen(n);
+            std::vector<std::pair<size_t, size_t>> ranges = { { 0, 0 }, { n, 0 }, { 0, n }, { 0, n / 2 }, { n / 2, n - n / 2 }, { n / 3, n / 3 }, { n / 3, n / 3 } };
+            for(size_t q = 0; q < 50; q++) {
+                size_t const pos = gen() % n;
+                size_t const len = std::min(size_t(gen() % 100), n - pos);
+                ranges.push_back({ pos, len });
+                if(q % 5 == 0) ranges.push_back({ pos + len, std::min(size_t(gen() % 100), n - (pos + len)) }); // adjacent
+                if(q % 7 == 0) ranges.push_back({ pos + len / 2, std::min(len, n - (pos + len / 2)) });      // overlapping
+                if(q % 11 == 0) ranges.push_back({ pos, 0 });
+            }
+
+            for(int const threads : { 1, 3 }) {
+                auto const result = index.extract(std::span<std::pair<size_t, size_t> const>(ranges), threads);
+                REQUIRE(result.size() == ranges.size());
+                for(size_t i = 0; i < ranges.size(); i++) CHECK(result[i] == s.substr(ranges[i].first, ranges[i].second));
+            }
+        }
+    }
+
+    TEST_CASE("parse blockwise") {
+        for(auto const& s : inputs()) {
+            size_t const n = s.length();
+
+            // windows that are smaller than the input and do not divide it, that divide it, that equal it and that exceed it
+            for(size_t const window : { size_t(7), n / 3 + 1, std::max(n / 4, size_t(1)), std::max(n, size_t(1)), n + 100 }) {
+                std::istringstream in(s);
+                std::vector<Phrase<int32_t>> parsing;
+                size_t const z = parse_blockwise(in, window, [&](Phrase<int32_t> const& f){ parsing.push_back(f); });
+                CHECK(z == parsing.size());
+                CHECK(decompress(parsing) == s);
+                if(window >= n) CHECK(same_parsing(parsing, parse(s)));
+
+                // streaming the phrases through an encoder, as the command line tool does
+                std::istringstream in64(s);
+                std::stringstream buf;
+                Encoder<int64_t> enc(buf);
+                CHECK(parse_blockwise<int64_t>(in64, window, enc) == z);
+                enc.finish();
+                auto const decoded = decode<int64_t>(buf);
+                REQUIRE(decoded.size() == z);
+                CHECK(decompress(decoded) == s);
+            }
+        }
+    }
+
+    TEST_CASE("parse with bounded latency") {
+        for(auto const& s : inputs()) {
+            for(size_t const num_chunks : { 1, 4 }) {
+                // every phrase obeys the maximum phrase length
+                for(size_t const max_phrase_len : { 1, 2, 5, 64 }) {
+                    Options options;
+                    options.num_chunks = num_chunks;
+                    options.max_phrase_len = max_phrase_len;
+                    auto const parsing = parse(s, options);
+                    CHECK(decompress(parsing) == s);
+                    for(auto const& f : parsing) REQUIRE(size_t(f.len) <= max_phrase_len);
+                }
+
+                Options options;
+                options.num_chunks = num_chunks;
+                options.requery = false;
+                CHECK(decompress(parse(s, options)) == s);
+
+                options.max_rmq_interval = 16;
+                options.max_phrase_len = 100;
+                auto const parsing = parse(s, options);
+                CHECK(decompress(parsing) == s);
+                for(auto const& f : parsing) REQUIRE(f.len <= 100);
+            }
+        }
+
+        // the limits also apply to the phrases copying from a reference
+        for(auto const& [r, s] : reference_inputs()) {
+            auto const ref = Reference::compute(r);
+            for(size_t const max_phrase_len : { 1, 5 }) {
+                Options options;
+                options.max_phrase_len = max_phrase_len;
+                options.max_rmq_interval = 16;
+                options.requery = false;
+                auto const parsing = parse(s, ref, options);
+                CHECK(decompress(parsing, ref) == s);
+                for(auto const& f : parsing) REQUIRE(size_t(f.len) <= max_phrase_len);
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,165 @@
+/**
+ * test_rmq.cpp
+ * part of pdinklag/lzend
+ * 
+ * MIT License
+ * 
+ * Copyright (c) Patrick Dinklage
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#define DOCTEST_CONFIG_IMPLEMENT
+#include "doctest.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+#include <rmq/rmq.hpp>
+
+// when built with an instruction set enabled to cover the vectorized scan, RMQ_TEST_SIMD names it (see main)
+#ifdef RMQ_TEST_SIMD
+static_assert(rmq::internal::simd_lanes > 0 && rmq::internal::simd_lanes_u8 > 0, "the vectorized scan is not enabled");
+#endif
+
+namespace rmq::test {
+
+// generates random values, where a small range yields many ties
+template<typename Value>
+std::vector<Value> random_values(size_t const n, uint64_t const range, uint32_t const seed) {
+    std::mt19937_64 gen(seed);
+    std::vector<Value> v(n);
+    for(auto& x : v) x = Value(int64_t(gen() % range) - (std::is_signed_v<Value> ? int64_t(range / 2) : 0));
+    return v;
+}
+
+// the sizes to test, including the block boundaries of rmq::RMQ
+std::vector<size_t> sizes() {
+    std::vector<size_t> result = { 0, 1, 2, 63, 64, 65, 127, 128, 129, 191, 192, 193, 500, 4097 };
+    std::mt19937 gen(1);
+    for(size_t k = 0; k < 4; k++) result.push_back(1 + gen() % 10000);
+    return result;
+}
+
+// checks that the given query function returns the leftmost minimum (or maximum) for all intervals of small inputs and random intervals otherwise
+template<bool minimum, typename Value, typename Query>
+void check_queries(std::span<Value const> const data, Query const& query) {
+    size_t const n = data.size();
+    auto better = [](Value const a, Value const b){ return minimum ? a < b : a > b; };
+
+    // nb: mismatches are counted rather than checked one by one, which would dominate the running time
+    size_t mismatches = 0;
+    if(n <= 600) {
+        for(size_t i = 0; i < n; i++) {
+            size_t expected = i;
+            for(size_t j = i; j < n; j++) {
+                if(better(data[j], data[expected])) expected = j;
+                mismatches += (query(i, j) != expected);
+            }
+        }
+    } else {
+        std::mt19937 gen(n);
+        for(size_t q = 0; q < 20000; q++) {
+            size_t const i = gen() % n;
+            size_t const j = i + (q % 8 == 0 ? gen() % (n - i) : gen() % std::min(n - i, size_t(256)));
+            size_t expected = i;
+            for(size_t k = i; k <= j; k++) {
+                if(better(data[k], data[expected])) expected = k;
+            }
+            mismatches += (query(i, j) != expected);
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+template<typename Value, bool minimum>
+void check_min_scan() {
+    for(size_t const n : sizes()) {
+        for(uint64_t const range : { 4, 1000000 }) {
+            auto const data = random_values<Value>(n, range, n + range);
+            check_queries<minimum>(std::span<Value const>(data), [&](size_t const i, size_t const j){
+                Value min;
+                auto const pos = min_scan<minimum>(data.data(), uint32_t(i), uint32_t(j + 1), min);
+                return min == data[pos] ? size_t(pos) : SIZE_MAX;
+            });
+        }
+    }
+}
+
+template<typename RMQ, typename Value, bool minimum>
+void check_rmq() {
+    for(size_t const n : sizes()) {
+        for(uint64_t const range : { 4, 1000000 }) {
+            auto const data = random_values<Value>(n, range, n + range);
+            RMQ const rmq(data.data(), n);
+            check_queries<minimum>(std::span<Value const>(data), [&](size_t const i, size_t const j){ return size_t(rmq(i, j)); });
+
+            // nb: construction using multiple threads yields the same structure
+            RMQ const rmq_parallel(data.data(), n, 3);
+            if(n > 0) CHECK(size_t(rmq_parallel(0, n - 1)) == size_t(rmq(0, n - 1)));
+        }
+    }
+}
+
+TEST_SUITE("rmq") {
+    TEST_CASE("in-block minimum scan") {
+        check_min_scan<int32_t, true>();
+        check_min_scan<int32_t, false>();
+        check_min_scan<uint8_t, true>();
+        check_min_scan<uint8_t, false>();
+        check_min_scan<uint32_t, true>();
+    }
+
+    TEST_CASE("Bender-Farach-Colton RMQ") {
+        check_rmq<RMQBenderFarachColton<int32_t, uint32_t>, int32_t, true>();
+        check_rmq<RMQBenderFarachColton<int32_t, uint32_t, false>, int32_t, false>();
+    }
+
+    TEST_CASE("two-level RMQ with the Bender-Farach-Colton engine") {
+        check_rmq<RMQ<int32_t, 64, uint32_t, true, RMQBenderFarachColton>, int32_t, true>();
+        check_rmq<RMQ<int32_t, 64, uint32_t, false, RMQBenderFarachColton>, int32_t, false>();
+        check_rmq<RMQ<uint8_t, 64, uint32_t, true, RMQBenderFarachColton>, uint8_t, true>();
+        check_rmq<RMQ<int64_t, 16, uint64_t, true, RMQBenderFarachColton>, int64_t, true>();
+    }
+
+    TEST_CASE("stack bitmask RMQ") {
+        check_rmq<RMQStackBitmask<int32_t, uint32_t>, int32_t, true>();
+        check_rmq<RMQStackBitmask<int32_t, uint32_t, false>, int32_t, false>();
+        check_rmq<RMQStackBitmask<uint8_t, uint32_t>, uint8_t, true>();
+    }
+
+    TEST_CASE("two-level RMQ with the stack bitmask engine") {
+        check_rmq<RMQ<int32_t, 64, uint32_t, true, RMQStackBitmask>, int32_t, true>();
+        check_rmq<RMQ<int32_t, 64, uint32_t, false, RMQStackBitmask>, int32_t, false>();
+        check_rmq<RMQ<uint8_t, 64, uint32_t, true, RMQStackBitmask>, uint8_t, true>();
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+#if defined(RMQ_TEST_SIMD) && (defined(__x86_64__) || defined(__i386__))
+    // skip the test if the machine lacks the instruction set it was built for
+    if(!__builtin_cpu_supports(RMQ_TEST_SIMD)) return 77;
+#endif
+    return doctest::Context(argc, argv).run();
+}